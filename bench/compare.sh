@@ -0,0 +1,20 @@
+#!/bin/sh
+#
+# Compare two result files written by bench/run.sh, printing the change in
+# average latency for every area and type present in both.
+#
+#   bench/compare.sh old.csv new.csv
+
+if [ $# -ne 2 ]; then
+	echo "usage: $0 old.csv new.csv" >&2
+	exit 2
+fi
+
+awk -F, '
+	FNR == 1 { next }
+	NR == FNR { old[$3 "," $4] = $10; next }
+	($3 "," $4) in old {
+		printf "%-14s %-9s %12.3f ms %12.3f ms %+8.1f%%\n", $3, $4,
+			old[$3 "," $4], $10, (old[$3 "," $4] > 0 ? ($10 / old[$3 "," $4] - 1) * 100 : 0)
+	}
+' "$1" "$2"
@@ -0,0 +1,92 @@
+#!/bin/sh
+#
+# Run the pg_duration benchmark suite and write one CSV row per area and
+# column type.  Connection settings come from the usual PG* environment
+# variables.  The COPY areas go through psql's \copy, with the load files
+# kept in a temporary directory that is removed on exit.
+#
+#   BENCH_ROWS     rows per table (default 1000000)
+#   BENCH_TIME     seconds per pgbench run (default 10)
+#   BENCH_CLIENTS  pgbench clients (default 1)
+#   BENCH_AREAS    scripts in bench/scripts to run (default all)
+#   BENCH_TYPES    column types to compare (default "duration int8 interval")
+#   BENCH_OUTPUT   results file (default bench_results.csv)
+
+set -e
+
+cd "$(dirname "$0")/.."
+
+PSQL=${PSQL:-psql}
+PGBENCH=${PGBENCH:-pgbench}
+BENCH_ROWS=${BENCH_ROWS:-1000000}
+BENCH_TIME=${BENCH_TIME:-10}
+BENCH_CLIENTS=${BENCH_CLIENTS:-1}
+BENCH_AREAS=${BENCH_AREAS:-"copy_in copy_out compare arith agg_serial agg_parallel agg_grouped sort index_build
+	interval_cast hash_join in_list scale_float8 scale_int8 series_unnest series_sum
+	array_unnest array_sum"}
+BENCH_TYPES=${BENCH_TYPES:-"duration int8 interval"}
+BENCH_OUTPUT=${BENCH_OUTPUT:-bench_results.csv}
+
+revision=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+
+# the COPY scripts run psql through pgbench's \shell, which sees these
+BENCH_DIR=$(mktemp -d "${TMPDIR:-/tmp}/pg_duration_bench.XXXXXX")
+trap 'rm -rf "$BENCH_DIR"' EXIT
+export PSQL BENCH_DIR
+
+"$PSQL" -X -q -v rows="$BENCH_ROWS" -f bench/setup.sql >/dev/null
+server_version=$("$PSQL" -X -A -t -c 'SHOW server_version_num')
+
+for type in $BENCH_TYPES; do
+	"$PSQL" -X -q -c "\\copy bench_$type TO '$BENCH_DIR/$type.copy'"
+done
+
+echo "revision,server_version,area,type,rows,clients,seconds,transactions,tps,latency_ms" > "$BENCH_OUTPUT"
+
+for area in $BENCH_AREAS; do
+	for type in $BENCH_TYPES; do
+		case $type in
+			duration)
+				cutoff="'00:00:30'::duration"
+				step="'00:00:01'::duration"
+				as_interval="v"
+				series_sum="series_sum(v)"
+				array_sum="array_sum(v)"
+				;;
+			int8)
+				cutoff="30000000::int8"
+				step="1000000::int8"
+				as_interval="(v * interval '1 us')"
+				series_sum="(SELECT sum(x) FROM unnest(v) x)"
+				array_sum="(SELECT sum(x) FROM unnest(v) x)"
+				;;
+			interval)
+				cutoff="'00:00:30'::interval"
+				step="'00:00:01'::interval"
+				as_interval="v"
+				series_sum="(SELECT sum(x) FROM unnest(v) x)"
+				array_sum="(SELECT sum(x) FROM unnest(v) x)"
+				;;
+			*)
+				echo "unknown type: $type" >&2
+				exit 1
+				;;
+		esac
+
+		# 100 of the table's own values, as an array constant
+		in_list=$("$PSQL" -X -A -t -c "SELECT quote_literal(array_agg(v)::text) || '::$type[]' FROM (SELECT v FROM bench_$type LIMIT 100) s")
+
+		out=$(BENCH_TYPE=$type "$PGBENCH" -n -M simple -T "$BENCH_TIME" -c "$BENCH_CLIENTS" \
+			-f "bench/scripts/$area.sql" -D type="$type" -D cutoff="$cutoff" \
+			-D step="$step" -D as_interval="$as_interval" \
+			-D series_sum="$series_sum" -D array_sum="$array_sum" \
+			-D in_list="$in_list")
+
+		xacts=$(echo "$out" | sed -n 's/^number of transactions actually processed: \([0-9]*\).*/\1/p')
+		tps=$(echo "$out" | sed -n 's/^tps = \([0-9.]*\).*/\1/p' | tail -n 1)
+		latency=$(echo "$out" | sed -n 's/^latency average = \([0-9.]*\) ms.*/\1/p')
+
+		echo "$revision,$server_version,$area,$type,$BENCH_ROWS,$BENCH_CLIENTS,$BENCH_TIME,$xacts,$tps,$latency" >> "$BENCH_OUTPUT"
+		echo "$area $type: $tps tps, $latency ms"
+	done
+done
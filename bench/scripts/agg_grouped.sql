@@ -0,0 +1,9 @@
+-- sum and avg over about a million groups, with a parallel hash aggregate
+-- forced so that the partial states are serialized to the leader
+SET max_parallel_workers_per_gather = 4;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET enable_sort = off;
+SET work_mem = '256MB';
+SELECT count(*), max(s), max(a) FROM (SELECT g, sum(v) AS s, avg(v) AS a FROM bench_grouped_:type GROUP BY g) grouped;
@@ -0,0 +1,6 @@
+-- sum, avg, min and max with a parallel plan forced
+SET max_parallel_workers_per_gather = 4;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SELECT sum(v), avg(v), min(v), max(v) FROM bench_:type;
@@ -0,0 +1,3 @@
+-- sum, avg, min and max without parallel workers
+SET max_parallel_workers_per_gather = 0;
+SELECT sum(v), avg(v), min(v), max(v) FROM bench_:type;
@@ -0,0 +1,2 @@
+-- addition and comparison over a full scan
+SELECT count(*) FROM bench_:type WHERE v + :step > :cutoff;
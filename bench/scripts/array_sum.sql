@@ -0,0 +1,3 @@
+-- array_sum() on duration[] (unnest for the other types)
+SET max_parallel_workers_per_gather = 0;
+SELECT sum(:array_sum) FROM bench_array_:type;
@@ -0,0 +1,3 @@
+-- arrays reduced through unnest and the aggregate machinery
+SET max_parallel_workers_per_gather = 0;
+SELECT sum((SELECT sum(x) FROM unnest(v) x)) FROM bench_array_:type;
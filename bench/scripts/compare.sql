@@ -0,0 +1,2 @@
+-- comparison operator over a full scan
+SELECT count(*) FROM bench_:type WHERE v < :cutoff;
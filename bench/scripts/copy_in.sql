@@ -0,0 +1,4 @@
+-- duration_in (and int8in, interval_in) through psql's \copy FROM, so that
+-- neither server file access nor a local server is needed
+TRUNCATE bench_copy_:type;
+\shell "$PSQL" -X -q -c "\copy bench_copy_$BENCH_TYPE FROM '$BENCH_DIR/$BENCH_TYPE.copy'"
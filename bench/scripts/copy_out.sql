@@ -0,0 +1,2 @@
+-- duration_out (and int8out, interval_out) through psql's \copy TO
+\shell "$PSQL" -X -q -c "\copy bench_$BENCH_TYPE TO '/dev/null'"
@@ -0,0 +1,5 @@
+-- hash join against a tenth of the table's values, without parallel workers
+SET max_parallel_workers_per_gather = 0;
+SET enable_mergejoin = off;
+SET enable_nestloop = off;
+SELECT count(*) FROM bench_:type t JOIN bench_probe_:type p ON t.v = p.v;
@@ -0,0 +1,3 @@
+-- = ANY over a 100-element array constant, which is probed through a hash
+-- table built with the type's hash function
+SELECT count(*) FROM bench_:type WHERE v = ANY (:in_list);
@@ -0,0 +1,4 @@
+-- btree index build
+SET client_min_messages = warning;
+DROP INDEX IF EXISTS bench_idx_:type;
+CREATE INDEX bench_idx_:type ON bench_:type (v);
@@ -0,0 +1,3 @@
+-- duration + interval resolves to interval + interval through the implicit
+-- duration_interval cast; int8 and interval are the baselines
+SELECT max(:as_interval + interval '1 s') FROM bench_:type;
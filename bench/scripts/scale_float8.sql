@@ -0,0 +1,3 @@
+-- multiplication and division by float8, the inexact path; pair with
+-- scale_int8
+SELECT max(v * 3.0::float8), max(v / 2.0::float8) FROM bench_:type;
@@ -0,0 +1,3 @@
+-- exact multiplication and division by int8; pair with scale_float8.
+-- interval has no int8 operators, so it goes through float8 here too
+SELECT max(v * 3::int8), max(v / 2::int8) FROM bench_:type;
@@ -0,0 +1,3 @@
+-- series_sum() on the compressed form (unnest for the other types)
+SET max_parallel_workers_per_gather = 0;
+SELECT sum(:series_sum) FROM bench_series_:type;
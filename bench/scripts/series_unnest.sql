@@ -0,0 +1,4 @@
+-- duration_series (arrays for the other types) expanded with unnest, against
+-- the plain table scan in agg_serial
+SET max_parallel_workers_per_gather = 0;
+SELECT sum(x) FROM bench_series_:type, unnest(v) x;
@@ -0,0 +1,5 @@
+-- in-memory sorts for ORDER BY and a window, without parallel workers
+SET max_parallel_workers_per_gather = 0;
+SET work_mem = '256MB';
+SELECT v FROM bench_:type ORDER BY v OFFSET 1000000000;
+SELECT max(n) FROM (SELECT count(*) OVER (ORDER BY v) AS n FROM bench_:type) s;
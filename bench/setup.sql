@@ -0,0 +1,81 @@
+-- Data generator for the benchmark suite.
+--
+-- Creates bench_duration, bench_int8 and bench_interval, each holding the
+-- same :rows latency-like values (exponentially distributed, mean 30 s),
+-- bench_probe_* tables with a tenth of those values to join against,
+-- bench_grouped_* tables with every value twice, spread over about :rows
+-- groups, bench_series_* tables with the values packed 1000 to a row in a
+-- duration_series (arrays for the other types), bench_array_* tables with
+-- the same values in arrays for every type, and empty bench_copy_* tables
+-- to load into.  run.sh writes the files they are
+-- loaded from.
+
+\set ON_ERROR_STOP 1
+\if :{?rows}
+\else
+\set rows 1000000
+\endif
+
+SET client_min_messages = warning;
+
+CREATE EXTENSION IF NOT EXISTS pg_duration;
+
+DROP TABLE IF EXISTS bench_duration, bench_int8, bench_interval,
+    bench_probe_duration, bench_probe_int8, bench_probe_interval,
+    bench_grouped_duration, bench_grouped_int8, bench_grouped_interval,
+    bench_series_duration, bench_series_int8, bench_series_interval,
+    bench_array_duration, bench_array_int8, bench_array_interval,
+    bench_copy_duration, bench_copy_int8, bench_copy_interval;
+
+SELECT setseed(0.5);
+
+CREATE TABLE bench_int8 AS
+    SELECT (-ln(1 - random()) * 30000000)::int8 AS v
+    FROM generate_series(1, :rows);
+CREATE TABLE bench_duration AS SELECT v::duration AS v FROM bench_int8;
+CREATE TABLE bench_interval AS SELECT v * interval '1 us' AS v FROM bench_int8;
+
+CREATE TABLE bench_probe_int8 AS
+    SELECT v FROM bench_int8 WHERE random() < 0.1;
+CREATE TABLE bench_probe_duration AS SELECT v::duration AS v FROM bench_probe_int8;
+CREATE TABLE bench_probe_interval AS SELECT v * interval '1 us' AS v FROM bench_probe_int8;
+
+CREATE TABLE bench_grouped_int8 AS
+    SELECT (random() * :rows)::int4 AS g, v
+    FROM bench_int8, generate_series(1, 2);
+CREATE TABLE bench_grouped_duration AS SELECT g, v::duration AS v FROM bench_grouped_int8;
+CREATE TABLE bench_grouped_interval AS SELECT g, v * interval '1 us' AS v FROM bench_grouped_int8;
+
+-- Each worker sees most of the groups, so the planner would rather gather
+-- every row than aggregate in the workers.  Understating the number of
+-- groups makes it pick the partial hash aggregate that agg_grouped measures.
+ALTER TABLE bench_grouped_int8 ALTER COLUMN g SET (n_distinct = 1000);
+ALTER TABLE bench_grouped_duration ALTER COLUMN g SET (n_distinct = 1000);
+ALTER TABLE bench_grouped_interval ALTER COLUMN g SET (n_distinct = 1000);
+
+CREATE TABLE bench_series_int8 AS
+    SELECT g, array_agg(v ORDER BY n) AS v
+    FROM (SELECT (n - 1) / 1000 AS g, n, v
+          FROM (SELECT row_number() OVER () AS n, v FROM bench_int8) numbered) s
+    GROUP BY g;
+CREATE TABLE bench_series_duration AS
+    SELECT g, (SELECT duration_series_agg(x::duration ORDER BY o) FROM unnest(v) WITH ORDINALITY u(x, o)) AS v
+    FROM bench_series_int8;
+CREATE TABLE bench_series_interval AS
+    SELECT g, array_agg(x * interval '1 us' ORDER BY o) AS v
+    FROM bench_series_int8, unnest(v) WITH ORDINALITY u(x, o)
+    GROUP BY g;
+
+CREATE TABLE bench_array_int8 AS TABLE bench_series_int8;
+CREATE TABLE bench_array_duration AS SELECT g, v::duration[] AS v FROM bench_series_int8;
+CREATE TABLE bench_array_interval AS TABLE bench_series_interval;
+
+CREATE TABLE bench_copy_int8 (LIKE bench_int8);
+CREATE TABLE bench_copy_duration (LIKE bench_duration);
+CREATE TABLE bench_copy_interval (LIKE bench_interval);
+
+VACUUM ANALYZE bench_int8, bench_duration, bench_interval,
+    bench_probe_int8, bench_probe_duration, bench_probe_interval,
+    bench_grouped_int8, bench_grouped_duration, bench_grouped_interval,
+    bench_series_int8, bench_series_duration, bench_series_interval,
+    bench_array_int8, bench_array_duration, bench_array_interval;
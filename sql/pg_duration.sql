@@ -38,17 +38,54 @@ CREATE OR REPLACE FUNCTION duration_cmp(duration, duration)
 
 COMMENT ON FUNCTION duration_cmp(duration, duration) IS 'btree comparison function';
 
+CREATE OR REPLACE FUNCTION duration_sortsupport(internal)
+	RETURNS void
+	AS 'MODULE_PATHNAME'
+	LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sortsupport(internal) IS 'btree sort support function';
+
 CREATE OR REPLACE FUNCTION hash_duration(duration)
 	RETURNS int4
 	AS 'MODULE_PATHNAME'
 	LANGUAGE C STRICT IMMUTABLE;
 
+CREATE OR REPLACE FUNCTION hash_duration_extended(duration, int8)
+	RETURNS int8
+	AS 'MODULE_PATHNAME'
+	LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION hash_duration_extended(duration, int8) IS 'hash with seed';
+
+CREATE OR REPLACE FUNCTION in_range(duration, duration, duration, bool, bool)
+	RETURNS bool
+	AS 'MODULE_PATHNAME', 'in_range_duration_duration'
+	LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION in_range(duration, duration, duration, bool, bool) IS 'window RANGE support';
+
+CREATE OR REPLACE FUNCTION duration_minmax_multi_distance(internal, internal)
+	RETURNS float8
+	AS 'MODULE_PATHNAME'
+	LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_minmax_multi_distance(internal, internal) IS 'BRIN minmax-multi distance function';
+
 -- Comparison methods
 
+CREATE FUNCTION duration_cmp_support(internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_cmp_support(internal) IS
+'planner support for comparisons of truncated durations';
+
 CREATE FUNCTION duration_lt(duration, duration)
 RETURNS bool
 AS 'MODULE_PATHNAME'
-LANGUAGE C STRICT IMMUTABLE;
+LANGUAGE C STRICT IMMUTABLE
+SUPPORT duration_cmp_support;
 
 COMMENT ON FUNCTION duration_lt(duration, duration) IS
 'less than';
@@ -56,7 +93,8 @@ COMMENT ON FUNCTION duration_lt(duration, duration) IS
 CREATE FUNCTION duration_le(duration, duration)
 RETURNS bool
 AS 'MODULE_PATHNAME'
-LANGUAGE C STRICT IMMUTABLE;
+LANGUAGE C STRICT IMMUTABLE
+SUPPORT duration_cmp_support;
 
 COMMENT ON FUNCTION duration_le(duration, duration) IS
 'less than or equal';
@@ -64,7 +102,8 @@ COMMENT ON FUNCTION duration_le(duration, duration) IS
 CREATE FUNCTION duration_gt(duration, duration)
 RETURNS bool
 AS 'MODULE_PATHNAME'
-LANGUAGE C STRICT IMMUTABLE;
+LANGUAGE C STRICT IMMUTABLE
+SUPPORT duration_cmp_support;
 
 COMMENT ON FUNCTION duration_gt(duration, duration) IS
 'greater than';
@@ -72,7 +111,8 @@ COMMENT ON FUNCTION duration_gt(duration, duration) IS
 CREATE FUNCTION duration_ge(duration, duration)
 RETURNS bool
 AS 'MODULE_PATHNAME'
-LANGUAGE C STRICT IMMUTABLE;
+LANGUAGE C STRICT IMMUTABLE
+SUPPORT duration_cmp_support;
 
 COMMENT ON FUNCTION duration_ge(duration, duration) IS
 'greater than or equal';
@@ -80,7 +120,8 @@ COMMENT ON FUNCTION duration_ge(duration, duration) IS
 CREATE FUNCTION duration_eq(duration, duration)
 RETURNS bool
 AS 'MODULE_PATHNAME'
-LANGUAGE C STRICT IMMUTABLE;
+LANGUAGE C STRICT IMMUTABLE
+SUPPORT duration_cmp_support;
 
 COMMENT ON FUNCTION duration_eq(duration, duration) IS
 'equal';
@@ -135,6 +176,96 @@ LANGUAGE C STRICT IMMUTABLE;
 COMMENT ON FUNCTION duration_div(duration, float8) IS
 'division';
 
+CREATE FUNCTION duration_dist(duration, duration)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_dist(duration, duration) IS
+'distance';
+
+-- Date/time arithmetic methods
+
+CREATE FUNCTION timestamp_pl_duration(timestamp, duration)
+RETURNS timestamp
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION timestamp_pl_duration(timestamp, duration) IS
+'plus';
+
+CREATE FUNCTION timestamp_mi_duration(timestamp, duration)
+RETURNS timestamp
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION timestamp_mi_duration(timestamp, duration) IS
+'minus';
+
+CREATE FUNCTION timestamptz_pl_duration(timestamptz, duration)
+RETURNS timestamptz
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION timestamptz_pl_duration(timestamptz, duration) IS
+'plus';
+
+CREATE FUNCTION timestamptz_mi_duration(timestamptz, duration)
+RETURNS timestamptz
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION timestamptz_mi_duration(timestamptz, duration) IS
+'minus';
+
+CREATE FUNCTION date_pl_duration(date, duration)
+RETURNS timestamp
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION date_pl_duration(date, duration) IS
+'plus';
+
+CREATE FUNCTION date_mi_duration(date, duration)
+RETURNS timestamp
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION date_mi_duration(date, duration) IS
+'minus';
+
+CREATE FUNCTION time_pl_duration(time, duration)
+RETURNS time
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION time_pl_duration(time, duration) IS
+'plus';
+
+CREATE FUNCTION time_mi_duration(time, duration)
+RETURNS time
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION time_mi_duration(time, duration) IS
+'minus';
+
+CREATE FUNCTION duration_diff(timestamp, timestamp)
+RETURNS duration
+AS 'MODULE_PATHNAME', 'timestamp_diff_duration'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_diff(timestamp, timestamp) IS
+'difference between timestamps as a duration';
+
+CREATE FUNCTION duration_diff(timestamptz, timestamptz)
+RETURNS duration
+AS 'MODULE_PATHNAME', 'timestamp_diff_duration'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_diff(timestamptz, timestamptz) IS
+'difference between timestamps as a duration';
+
 -- Public routines
 
 CREATE FUNCTION make_duration(hours int4 DEFAULT 0, mins int4 DEFAULT 0, secs float8 DEFAULT 0.0)
@@ -152,6 +283,26 @@ RETURNS duration
 AS 'MODULE_PATHNAME', 'duration_trunc'
 LANGUAGE C STRICT IMMUTABLE;
 
+CREATE FUNCTION date_bin(duration, timestamptz, timestamptz)
+RETURNS timestamptz
+AS 'MODULE_PATHNAME', 'date_bin_duration'
+LANGUAGE C STRICT IMMUTABLE;
+
+CREATE FUNCTION date_bin(duration, timestamp, timestamp)
+RETURNS timestamp
+AS 'MODULE_PATHNAME', 'date_bin_duration'
+LANGUAGE C STRICT IMMUTABLE;
+
+CREATE FUNCTION duration_bin(duration, duration)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+CREATE FUNCTION duration_bin(duration, duration, duration)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
 CREATE FUNCTION date_part(text, duration)
 RETURNS float8
 AS 'MODULE_PATHNAME', 'duration_part'
@@ -174,6 +325,16 @@ RETURNS duration
 AS 'MODULE_PATHNAME'
 LANGUAGE C STRICT IMMUTABLE;
 
+-- Range methods
+
+CREATE FUNCTION duration_subdiff(duration, duration)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_subdiff(duration, duration) IS
+'float8 difference of two duration values';
+
 -- Aggregate methods
 
 CREATE FUNCTION duration_avg_accum(internal, duration)
@@ -229,7 +390,87 @@ RETURNS duration
 AS 'MODULE_PATHNAME'
 LANGUAGE C IMMUTABLE;
 
-COMMENT ON FUNCTION duration_avg(internal) IS
+COMMENT ON FUNCTION duration_sum(internal) IS
+'moving sum final function';
+
+CREATE FUNCTION duration_accum(internal, duration)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_accum(internal, duration) IS
+'variance and standard deviation transition function';
+
+CREATE FUNCTION duration_var_pop(internal)
+RETURNS numeric
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_var_pop(internal) IS
+'var_pop final function';
+
+CREATE FUNCTION duration_var_samp(internal)
+RETURNS numeric
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_var_samp(internal) IS
+'var_samp final function';
+
+CREATE FUNCTION duration_stddev_pop(internal)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_stddev_pop(internal) IS
+'stddev_pop final function';
+
+CREATE FUNCTION duration_stddev_samp(internal)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_stddev_samp(internal) IS
+'stddev_samp final function';
+
+CREATE FUNCTION duration_sum_accum(internal, duration)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sum_accum(internal, duration) IS
+'sum transition function';
+
+CREATE FUNCTION duration_sum_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sum_combine(internal, internal) IS
+'sum combine function';
+
+CREATE FUNCTION duration_sum_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sum_serialize(internal) IS
+'sum serialize function';
+
+CREATE FUNCTION duration_sum_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sum_deserialize(bytea, internal) IS
+'sum deserialize function';
+
+CREATE FUNCTION duration_sum_final(internal)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sum_final(internal) IS
 'sum final function';
 
 CREATE FUNCTION duration_smaller(duration, duration)
@@ -248,6 +489,131 @@ LANGUAGE C STRICT IMMUTABLE;
 COMMENT ON FUNCTION duration_larger(duration, duration) IS
 'max transition function';
 
+CREATE FUNCTION duration_smaller_accum(internal, duration)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_smaller_accum(internal, duration) IS
+'moving min transition function';
+
+CREATE FUNCTION duration_larger_accum(internal, duration)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_larger_accum(internal, duration) IS
+'moving max transition function';
+
+CREATE FUNCTION duration_minmax_accum_inv(internal, duration)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_minmax_accum_inv(internal, duration) IS
+'moving min and max inverse transition function';
+
+CREATE FUNCTION duration_minmax_final(internal)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_minmax_final(internal) IS
+'moving min and max final function';
+
+CREATE FUNCTION duration_percentile_accum(internal, duration)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_percentile_accum(internal, duration) IS
+'percentile and median transition function';
+
+CREATE FUNCTION duration_percentile_disc_final(internal, float8, duration)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_percentile_disc_final(internal, float8, duration) IS
+'percentile_disc final function';
+
+CREATE FUNCTION duration_percentile_cont_final(internal, float8, duration)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_percentile_cont_final(internal, float8, duration) IS
+'percentile_cont final function';
+
+CREATE FUNCTION duration_median_final(internal)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_median_final(internal) IS
+'median final function';
+
+-- GiST support methods
+
+CREATE TYPE gist_durationkey;
+
+CREATE FUNCTION gist_durationkey_in(cstring)
+RETURNS gist_durationkey
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE FUNCTION gist_durationkey_out(gist_durationkey)
+RETURNS cstring
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE gist_durationkey (
+    INTERNALLENGTH = 16,
+    INPUT = gist_durationkey_in,
+    OUTPUT = gist_durationkey_out,
+    ALIGNMENT = double
+);
+
+CREATE FUNCTION gist_duration_consistent(internal, duration, int2, oid, internal)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE FUNCTION gist_duration_union(internal, internal)
+RETURNS gist_durationkey
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE FUNCTION gist_duration_compress(internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE FUNCTION gist_duration_fetch(internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE FUNCTION gist_duration_penalty(internal, internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE FUNCTION gist_duration_picksplit(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE FUNCTION gist_duration_same(gist_durationkey, gist_durationkey, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE FUNCTION gist_duration_distance(internal, duration, int2, oid, internal)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
 -- Define duration type
 
 CREATE TYPE duration (
@@ -257,7 +623,8 @@ CREATE TYPE duration (
     RECEIVE = duration_recv,
     SEND = duration_send,
     PASSEDBYVALUE,
-    ALIGNMENT = double
+    ALIGNMENT = double,
+    CATEGORY = 'T'
 );
 
 COMMENT ON TYPE duration IS 'duration of time';
@@ -314,7 +681,8 @@ CREATE OPERATOR = (
 	NEGATOR = '<>',
 	RESTRICT = eqsel,
 	JOIN = eqjoinsel,
-	MERGES
+	MERGES,
+	HASHES
 );
 
 CREATE OPERATOR <> (
@@ -359,37 +727,161 @@ CREATE OPERATOR / (
 	PROCEDURE = duration_div
 );
 
--- Create the operator classes for indexing
+CREATE OPERATOR <-> (
+	LEFTARG = duration,
+	RIGHTARG = duration,
+	PROCEDURE = duration_dist,
+	COMMUTATOR = '<->'
+);
 
-CREATE OPERATOR CLASS duration_ops
-    DEFAULT FOR TYPE duration USING btree AS
-        OPERATOR        1       <,
-        OPERATOR        2       <=,
-        OPERATOR        3       =,
-        OPERATOR        4       >=,
-        OPERATOR        5       >,
-        FUNCTION        1       duration_cmp(duration, duration);
+CREATE OPERATOR + (
+	LEFTARG = timestamp,
+	RIGHTARG = duration,
+	PROCEDURE = timestamp_pl_duration
+);
 
-CREATE OPERATOR CLASS duration_ops
-    DEFAULT FOR TYPE duration USING hash AS
-    OPERATOR    1   =,
-    FUNCTION    1   hash_duration(duration);
+CREATE OPERATOR - (
+	LEFTARG = timestamp,
+	RIGHTARG = duration,
+	PROCEDURE = timestamp_mi_duration
+);
 
--- Create casts
+CREATE OPERATOR + (
+	LEFTARG = timestamptz,
+	RIGHTARG = duration,
+	PROCEDURE = timestamptz_pl_duration
+);
 
-CREATE CAST (duration AS interval)
-    WITH FUNCTION duration_interval(duration)
-    AS IMPLICIT;
+CREATE OPERATOR - (
+	LEFTARG = timestamptz,
+	RIGHTARG = duration,
+	PROCEDURE = timestamptz_mi_duration
+);
 
-CREATE CAST (interval AS duration)
-    WITH FUNCTION interval_duration(interval);
+CREATE OPERATOR + (
+	LEFTARG = date,
+	RIGHTARG = duration,
+	PROCEDURE = date_pl_duration
+);
+
+CREATE OPERATOR - (
+	LEFTARG = date,
+	RIGHTARG = duration,
+	PROCEDURE = date_mi_duration
+);
+
+CREATE OPERATOR + (
+	LEFTARG = time,
+	RIGHTARG = duration,
+	PROCEDURE = time_pl_duration
+);
+
+CREATE OPERATOR - (
+	LEFTARG = time,
+	RIGHTARG = duration,
+	PROCEDURE = time_mi_duration
+);
+
+-- Create the operator classes for indexing
+
+CREATE OPERATOR CLASS duration_ops
+    DEFAULT FOR TYPE duration USING btree AS
+        OPERATOR        1       <,
+        OPERATOR        2       <=,
+        OPERATOR        3       =,
+        OPERATOR        4       >=,
+        OPERATOR        5       >,
+        FUNCTION        1       duration_cmp(duration, duration),
+        FUNCTION        2       duration_sortsupport(internal),
+        FUNCTION        3       in_range(duration, duration, duration, bool, bool);
+
+CREATE OPERATOR CLASS duration_ops
+    DEFAULT FOR TYPE duration USING hash AS
+    OPERATOR    1   =,
+    FUNCTION    1   hash_duration(duration),
+    FUNCTION    2   hash_duration_extended(duration, int8);
+
+CREATE OPERATOR CLASS duration_minmax_ops
+    DEFAULT FOR TYPE duration USING brin AS
+        OPERATOR        1       <,
+        OPERATOR        2       <=,
+        OPERATOR        3       =,
+        OPERATOR        4       >=,
+        OPERATOR        5       >,
+        FUNCTION        1       brin_minmax_opcinfo(internal),
+        FUNCTION        2       brin_minmax_add_value(internal, internal, internal, internal),
+        FUNCTION        3       brin_minmax_consistent(internal, internal, internal),
+        FUNCTION        4       brin_minmax_union(internal, internal, internal);
+
+CREATE OPERATOR CLASS duration_minmax_multi_ops
+    FOR TYPE duration USING brin AS
+        OPERATOR        1       <,
+        OPERATOR        2       <=,
+        OPERATOR        3       =,
+        OPERATOR        4       >=,
+        OPERATOR        5       >,
+        FUNCTION        1       brin_minmax_multi_opcinfo(internal),
+        FUNCTION        2       brin_minmax_multi_add_value(internal, internal, internal, internal),
+        FUNCTION        3       brin_minmax_multi_consistent(internal, internal, internal, int4),
+        FUNCTION        4       brin_minmax_multi_union(internal, internal, internal),
+        FUNCTION        5       brin_minmax_multi_options(internal),
+        FUNCTION        11      duration_minmax_multi_distance(internal, internal);
+
+CREATE OPERATOR CLASS duration_bloom_ops
+    FOR TYPE duration USING brin AS
+        OPERATOR        1       =,
+        FUNCTION        1       brin_bloom_opcinfo(internal),
+        FUNCTION        2       brin_bloom_add_value(internal, internal, internal, internal),
+        FUNCTION        3       brin_bloom_consistent(internal, internal, internal, int4),
+        FUNCTION        4       brin_bloom_union(internal, internal, internal),
+        FUNCTION        5       brin_bloom_options(internal),
+        FUNCTION        11      hash_duration(duration);
+
+CREATE OPERATOR CLASS gist_duration_ops
+    DEFAULT FOR TYPE duration USING gist AS
+        OPERATOR        1       <,
+        OPERATOR        2       <=,
+        OPERATOR        3       =,
+        OPERATOR        4       >=,
+        OPERATOR        5       >,
+        OPERATOR        6       <>,
+        OPERATOR        15      <-> FOR ORDER BY duration_ops,
+        FUNCTION        1       gist_duration_consistent(internal, duration, int2, oid, internal),
+        FUNCTION        2       gist_duration_union(internal, internal),
+        FUNCTION        3       gist_duration_compress(internal),
+        FUNCTION        5       gist_duration_penalty(internal, internal, internal),
+        FUNCTION        6       gist_duration_picksplit(internal, internal),
+        FUNCTION        7       gist_duration_same(gist_durationkey, gist_durationkey, internal),
+        FUNCTION        8       gist_duration_distance(internal, duration, int2, oid, internal),
+        FUNCTION        9       gist_duration_fetch(internal),
+    STORAGE     gist_durationkey;
+
+-- Create casts
+
+CREATE CAST (duration AS interval)
+    WITH FUNCTION duration_interval(duration)
+    AS IMPLICIT;
+
+CREATE CAST (interval AS duration)
+    WITH FUNCTION interval_duration(interval);
+
+-- Create range types
+
+CREATE TYPE durationrange AS RANGE (
+    SUBTYPE = duration,
+    SUBTYPE_OPCLASS = duration_ops,
+    SUBTYPE_DIFF = duration_subdiff,
+    MULTIRANGE_TYPE_NAME = durationmultirange
+);
+
+COMMENT ON TYPE durationrange IS 'range of durations';
 
 -- Create aggregates
 
 CREATE AGGREGATE avg(duration)  (
     SFUNC = duration_avg_accum,
     STYPE = internal,
-    SSPACE = 32,
+    SSPACE = 80,
     FINALFUNC = duration_avg,
     COMBINEFUNC = duration_avg_combine,
     SERIALFUNC = duration_avg_serialize,
@@ -397,24 +889,120 @@ CREATE AGGREGATE avg(duration)  (
     MSFUNC = duration_avg_accum,
     MINVFUNC = duration_avg_accum_inv,
     MSTYPE = internal,
-    MSSPACE = 32,
+    MSSPACE = 80,
     MFINALFUNC = duration_avg,
     PARALLEL = SAFE
 );
 
 CREATE AGGREGATE sum(duration)  (
-    SFUNC = duration_avg_accum,
+    SFUNC = duration_sum_accum,
     STYPE = internal,
     SSPACE = 32,
-    FINALFUNC = duration_sum,
+    FINALFUNC = duration_sum_final,
+    COMBINEFUNC = duration_sum_combine,
+    SERIALFUNC = duration_sum_serialize,
+    DESERIALFUNC = duration_sum_deserialize,
+    MSFUNC = duration_avg_accum,
+    MINVFUNC = duration_avg_accum_inv,
+    MSTYPE = internal,
+    MSSPACE = 80,
+    MFINALFUNC = duration_sum,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE var_pop(duration)  (
+    SFUNC = duration_accum,
+    STYPE = internal,
+    SSPACE = 80,
+    FINALFUNC = duration_var_pop,
     COMBINEFUNC = duration_avg_combine,
     SERIALFUNC = duration_avg_serialize,
     DESERIALFUNC = duration_avg_deserialize,
-    MSFUNC = duration_avg_accum,
+    MSFUNC = duration_accum,
     MINVFUNC = duration_avg_accum_inv,
     MSTYPE = internal,
-    MSSPACE = 32,
-    MFINALFUNC = duration_sum,
+    MSSPACE = 80,
+    MFINALFUNC = duration_var_pop,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE var_samp(duration)  (
+    SFUNC = duration_accum,
+    STYPE = internal,
+    SSPACE = 80,
+    FINALFUNC = duration_var_samp,
+    COMBINEFUNC = duration_avg_combine,
+    SERIALFUNC = duration_avg_serialize,
+    DESERIALFUNC = duration_avg_deserialize,
+    MSFUNC = duration_accum,
+    MINVFUNC = duration_avg_accum_inv,
+    MSTYPE = internal,
+    MSSPACE = 80,
+    MFINALFUNC = duration_var_samp,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE variance(duration)  (
+    SFUNC = duration_accum,
+    STYPE = internal,
+    SSPACE = 80,
+    FINALFUNC = duration_var_samp,
+    COMBINEFUNC = duration_avg_combine,
+    SERIALFUNC = duration_avg_serialize,
+    DESERIALFUNC = duration_avg_deserialize,
+    MSFUNC = duration_accum,
+    MINVFUNC = duration_avg_accum_inv,
+    MSTYPE = internal,
+    MSSPACE = 80,
+    MFINALFUNC = duration_var_samp,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE stddev_pop(duration)  (
+    SFUNC = duration_accum,
+    STYPE = internal,
+    SSPACE = 80,
+    FINALFUNC = duration_stddev_pop,
+    COMBINEFUNC = duration_avg_combine,
+    SERIALFUNC = duration_avg_serialize,
+    DESERIALFUNC = duration_avg_deserialize,
+    MSFUNC = duration_accum,
+    MINVFUNC = duration_avg_accum_inv,
+    MSTYPE = internal,
+    MSSPACE = 80,
+    MFINALFUNC = duration_stddev_pop,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE stddev_samp(duration)  (
+    SFUNC = duration_accum,
+    STYPE = internal,
+    SSPACE = 80,
+    FINALFUNC = duration_stddev_samp,
+    COMBINEFUNC = duration_avg_combine,
+    SERIALFUNC = duration_avg_serialize,
+    DESERIALFUNC = duration_avg_deserialize,
+    MSFUNC = duration_accum,
+    MINVFUNC = duration_avg_accum_inv,
+    MSTYPE = internal,
+    MSSPACE = 80,
+    MFINALFUNC = duration_stddev_samp,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE stddev(duration)  (
+    SFUNC = duration_accum,
+    STYPE = internal,
+    SSPACE = 80,
+    FINALFUNC = duration_stddev_samp,
+    COMBINEFUNC = duration_avg_combine,
+    SERIALFUNC = duration_avg_serialize,
+    DESERIALFUNC = duration_avg_deserialize,
+    MSFUNC = duration_accum,
+    MINVFUNC = duration_avg_accum_inv,
+    MSTYPE = internal,
+    MSSPACE = 80,
+    MFINALFUNC = duration_stddev_samp,
     PARALLEL = SAFE
 );
 
@@ -423,7 +1011,12 @@ CREATE AGGREGATE min(duration)  (
     STYPE = duration,
     SORTOP = <,
     PARALLEL = SAFE,
-    COMBINEFUNC = duration_smaller
+    COMBINEFUNC = duration_smaller,
+    MSFUNC = duration_smaller_accum,
+    MINVFUNC = duration_minmax_accum_inv,
+    MSTYPE = internal,
+    MSSPACE = 304,
+    MFINALFUNC = duration_minmax_final
 );
 
 CREATE AGGREGATE max(duration)  (
@@ -431,5 +1024,1119 @@ CREATE AGGREGATE max(duration)  (
     STYPE = duration,
     SORTOP = >,
     PARALLEL = SAFE,
-    COMBINEFUNC = duration_larger
+    COMBINEFUNC = duration_larger,
+    MSFUNC = duration_larger_accum,
+    MINVFUNC = duration_minmax_accum_inv,
+    MSTYPE = internal,
+    MSSPACE = 304,
+    MFINALFUNC = duration_minmax_final
+);
+
+-- The array forms need the duration[] type, so they come last
+CREATE FUNCTION duration_percentile_disc_multi_final(internal, float8[], duration)
+RETURNS duration[]
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_percentile_disc_multi_final(internal, float8[], duration) IS
+'multiple percentile_disc final function';
+
+CREATE FUNCTION duration_percentile_cont_multi_final(internal, float8[], duration)
+RETURNS duration[]
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_percentile_cont_multi_final(internal, float8[], duration) IS
+'multiple percentile_cont final function';
+
+CREATE AGGREGATE percentile_disc(float8 ORDER BY duration)  (
+    SFUNC = duration_percentile_accum,
+    STYPE = internal,
+    FINALFUNC = duration_percentile_disc_final,
+    FINALFUNC_EXTRA,
+    FINALFUNC_MODIFY = READ_WRITE,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE percentile_cont(float8 ORDER BY duration)  (
+    SFUNC = duration_percentile_accum,
+    STYPE = internal,
+    FINALFUNC = duration_percentile_cont_final,
+    FINALFUNC_EXTRA,
+    FINALFUNC_MODIFY = READ_WRITE,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE percentile_disc(float8[] ORDER BY duration)  (
+    SFUNC = duration_percentile_accum,
+    STYPE = internal,
+    FINALFUNC = duration_percentile_disc_multi_final,
+    FINALFUNC_EXTRA,
+    FINALFUNC_MODIFY = READ_WRITE,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE percentile_cont(float8[] ORDER BY duration)  (
+    SFUNC = duration_percentile_accum,
+    STYPE = internal,
+    FINALFUNC = duration_percentile_cont_multi_final,
+    FINALFUNC_EXTRA,
+    FINALFUNC_MODIFY = READ_WRITE,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE median(duration)  (
+    SFUNC = duration_percentile_accum,
+    STYPE = internal,
+    FINALFUNC = duration_median_final,
+    FINALFUNC_MODIFY = READ_WRITE,
+    PARALLEL = SAFE
+);
+
+-- Create quantile sketches
+
+CREATE TYPE duration_sketch;
+
+CREATE FUNCTION duration_sketch_in(cstring)
+RETURNS duration_sketch
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+CREATE FUNCTION duration_sketch_out(duration_sketch)
+RETURNS cstring
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+CREATE FUNCTION duration_sketch_recv(internal)
+RETURNS duration_sketch
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+CREATE FUNCTION duration_sketch_send(duration_sketch)
+RETURNS bytea
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+CREATE TYPE duration_sketch (
+    INTERNALLENGTH = VARIABLE,
+    INPUT = duration_sketch_in,
+    OUTPUT = duration_sketch_out,
+    RECEIVE = duration_sketch_recv,
+    SEND = duration_sketch_send,
+    ALIGNMENT = double,
+    STORAGE = extended
+);
+
+COMMENT ON TYPE duration_sketch IS 'mergeable approximate quantile sketch of durations';
+
+CREATE FUNCTION duration_sketch_accum(internal, duration)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sketch_accum(internal, duration) IS
+'duration_sketch_agg transition function';
+
+CREATE FUNCTION duration_sketch_accum(internal, duration, float8)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sketch_accum(internal, duration, float8) IS
+'duration_sketch_agg transition function';
+
+CREATE FUNCTION duration_sketch_merge_accum(internal, duration_sketch)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sketch_merge_accum(internal, duration_sketch) IS
+'sketch_merge transition function';
+
+CREATE FUNCTION duration_sketch_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sketch_combine(internal, internal) IS
+'duration sketch combine function';
+
+CREATE FUNCTION duration_sketch_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sketch_serialize(internal) IS
+'duration sketch serialize function';
+
+CREATE FUNCTION duration_sketch_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sketch_deserialize(bytea, internal) IS
+'duration sketch deserialize function';
+
+CREATE FUNCTION duration_sketch_final(internal)
+RETURNS duration_sketch
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_sketch_final(internal) IS
+'duration sketch final function';
+
+CREATE FUNCTION quantile(duration_sketch, float8)
+RETURNS duration
+AS 'MODULE_PATHNAME', 'duration_sketch_quantile'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION quantile(duration_sketch, float8) IS
+'approximate quantile of a duration sketch';
+
+CREATE AGGREGATE duration_sketch_agg(duration)  (
+    SFUNC = duration_sketch_accum,
+    STYPE = internal,
+    FINALFUNC = duration_sketch_final,
+    COMBINEFUNC = duration_sketch_combine,
+    SERIALFUNC = duration_sketch_serialize,
+    DESERIALFUNC = duration_sketch_deserialize,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE duration_sketch_agg(duration, float8)  (
+    SFUNC = duration_sketch_accum,
+    STYPE = internal,
+    FINALFUNC = duration_sketch_final,
+    COMBINEFUNC = duration_sketch_combine,
+    SERIALFUNC = duration_sketch_serialize,
+    DESERIALFUNC = duration_sketch_deserialize,
+    PARALLEL = SAFE
+);
+
+CREATE AGGREGATE sketch_merge(duration_sketch)  (
+    SFUNC = duration_sketch_merge_accum,
+    STYPE = internal,
+    FINALFUNC = duration_sketch_final,
+    COMBINEFUNC = duration_sketch_combine,
+    SERIALFUNC = duration_sketch_serialize,
+    DESERIALFUNC = duration_sketch_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Create histograms
+
+CREATE TYPE duration_histogram AS (
+    lower duration[],
+    upper duration[],
+    count int8[]
+);
+
+COMMENT ON TYPE duration_histogram IS 'bounds and counts of the nonempty buckets of a duration histogram';
+
+CREATE FUNCTION duration_histogram_accum(internal, duration)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_histogram_accum(internal, duration) IS
+'duration_histogram transition function';
+
+CREATE FUNCTION duration_histogram_accum(internal, duration, int4)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_histogram_accum(internal, duration, int4) IS
+'duration_histogram transition function';
+
+CREATE FUNCTION duration_histogram_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_histogram_combine(internal, internal) IS
+'duration_histogram combine function';
+
+CREATE FUNCTION duration_histogram_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_histogram_serialize(internal) IS
+'duration_histogram serialize function';
+
+CREATE FUNCTION duration_histogram_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_histogram_deserialize(bytea, internal) IS
+'duration_histogram deserialize function';
+
+CREATE FUNCTION duration_histogram_final(internal)
+RETURNS duration_histogram
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_histogram_final(internal) IS
+'duration_histogram final function';
+
+CREATE AGGREGATE duration_histogram(duration)  (
+    SFUNC = duration_histogram_accum,
+    STYPE = internal,
+    FINALFUNC = duration_histogram_final,
+    COMBINEFUNC = duration_histogram_combine,
+    SERIALFUNC = duration_histogram_serialize,
+    DESERIALFUNC = duration_histogram_deserialize,
+    PARALLEL = SAFE
 );
+
+CREATE AGGREGATE duration_histogram(duration, int4)  (
+    SFUNC = duration_histogram_accum,
+    STYPE = internal,
+    FINALFUNC = duration_histogram_final,
+    COMBINEFUNC = duration_histogram_combine,
+    SERIALFUNC = duration_histogram_serialize,
+    DESERIALFUNC = duration_histogram_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Create set-returning functions
+
+CREATE FUNCTION generate_series_duration_support(internal)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION generate_series_duration_support(internal) IS
+'planner support for generate_series';
+
+CREATE FUNCTION generate_series(duration, duration, duration)
+RETURNS SETOF duration
+AS 'MODULE_PATHNAME', 'generate_series_duration'
+LANGUAGE C STRICT IMMUTABLE
+SUPPORT generate_series_duration_support;
+
+COMMENT ON FUNCTION generate_series(duration, duration, duration) IS
+'non-persistent series generator';
+
+CREATE FUNCTION generate_series(timestamptz, timestamptz, duration)
+RETURNS SETOF timestamptz
+AS 'MODULE_PATHNAME', 'generate_series_timestamptz_duration'
+LANGUAGE C STRICT IMMUTABLE
+SUPPORT generate_series_duration_support;
+
+COMMENT ON FUNCTION generate_series(timestamptz, timestamptz, duration) IS
+'non-persistent series generator';
+
+-- Create bigint conversions and comparisons
+
+CREATE FUNCTION to_duration_nanos(int8)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION to_duration_nanos(int8) IS
+'convert nanoseconds to duration';
+
+CREATE FUNCTION to_duration_micros(int8)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION to_duration_micros(int8) IS
+'convert microseconds to duration';
+
+CREATE FUNCTION duration_to_micros(duration)
+RETURNS int8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_to_micros(duration) IS
+'convert duration to microseconds';
+
+CREATE CAST (int8 AS duration)
+    WITH FUNCTION to_duration_micros(int8);
+
+CREATE CAST (duration AS int8)
+    WITH FUNCTION duration_to_micros(duration);
+
+CREATE FUNCTION duration_int8_cmp(duration, int8)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_int8_cmp(duration, int8) IS 'btree comparison function';
+
+CREATE FUNCTION duration_lt_int8(duration, int8)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_lt_int8(duration, int8) IS
+'less than';
+
+CREATE FUNCTION duration_le_int8(duration, int8)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_le_int8(duration, int8) IS
+'less than or equal';
+
+CREATE FUNCTION duration_gt_int8(duration, int8)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_gt_int8(duration, int8) IS
+'greater than';
+
+CREATE FUNCTION duration_ge_int8(duration, int8)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_ge_int8(duration, int8) IS
+'greater than or equal';
+
+CREATE FUNCTION duration_eq_int8(duration, int8)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_eq_int8(duration, int8) IS
+'equal';
+
+CREATE FUNCTION duration_ne_int8(duration, int8)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_ne_int8(duration, int8) IS
+'not equal';
+
+CREATE FUNCTION int8_duration_cmp(int8, duration)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION int8_duration_cmp(int8, duration) IS 'btree comparison function';
+
+CREATE FUNCTION int8_lt_duration(int8, duration)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION int8_lt_duration(int8, duration) IS
+'less than';
+
+CREATE FUNCTION int8_le_duration(int8, duration)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION int8_le_duration(int8, duration) IS
+'less than or equal';
+
+CREATE FUNCTION int8_gt_duration(int8, duration)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION int8_gt_duration(int8, duration) IS
+'greater than';
+
+CREATE FUNCTION int8_ge_duration(int8, duration)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION int8_ge_duration(int8, duration) IS
+'greater than or equal';
+
+CREATE FUNCTION int8_eq_duration(int8, duration)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION int8_eq_duration(int8, duration) IS
+'equal';
+
+CREATE FUNCTION int8_ne_duration(int8, duration)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION int8_ne_duration(int8, duration) IS
+'not equal';
+
+CREATE OPERATOR < (
+	LEFTARG = duration,
+	RIGHTARG = int8,
+	PROCEDURE = duration_lt_int8,
+	COMMUTATOR = '>',
+	NEGATOR = '>=',
+	RESTRICT = scalarltsel,
+	JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR <= (
+	LEFTARG = duration,
+	RIGHTARG = int8,
+	PROCEDURE = duration_le_int8,
+	COMMUTATOR = '>=',
+	NEGATOR = '>',
+	RESTRICT = scalarlesel,
+	JOIN = scalarlejoinsel
+);
+
+CREATE OPERATOR > (
+	LEFTARG = duration,
+	RIGHTARG = int8,
+	PROCEDURE = duration_gt_int8,
+	COMMUTATOR = '<',
+	NEGATOR = '<=',
+	RESTRICT = scalargtsel,
+	JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR >= (
+	LEFTARG = duration,
+	RIGHTARG = int8,
+	PROCEDURE = duration_ge_int8,
+	COMMUTATOR = '<=',
+	NEGATOR = '<',
+	RESTRICT = scalargesel,
+	JOIN = scalargejoinsel
+);
+
+CREATE OPERATOR = (
+	LEFTARG = duration,
+	RIGHTARG = int8,
+	PROCEDURE = duration_eq_int8,
+	COMMUTATOR = '=',
+	NEGATOR = '<>',
+	RESTRICT = eqsel,
+	JOIN = eqjoinsel,
+	HASHES
+);
+
+CREATE OPERATOR <> (
+	LEFTARG = duration,
+	RIGHTARG = int8,
+	PROCEDURE = duration_ne_int8,
+	COMMUTATOR = '<>',
+	NEGATOR = '=',
+	RESTRICT = neqsel,
+	JOIN = neqjoinsel
+);
+
+CREATE OPERATOR < (
+	LEFTARG = int8,
+	RIGHTARG = duration,
+	PROCEDURE = int8_lt_duration,
+	COMMUTATOR = '>',
+	NEGATOR = '>=',
+	RESTRICT = scalarltsel,
+	JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR <= (
+	LEFTARG = int8,
+	RIGHTARG = duration,
+	PROCEDURE = int8_le_duration,
+	COMMUTATOR = '>=',
+	NEGATOR = '>',
+	RESTRICT = scalarlesel,
+	JOIN = scalarlejoinsel
+);
+
+CREATE OPERATOR > (
+	LEFTARG = int8,
+	RIGHTARG = duration,
+	PROCEDURE = int8_gt_duration,
+	COMMUTATOR = '<',
+	NEGATOR = '<=',
+	RESTRICT = scalargtsel,
+	JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR >= (
+	LEFTARG = int8,
+	RIGHTARG = duration,
+	PROCEDURE = int8_ge_duration,
+	COMMUTATOR = '<=',
+	NEGATOR = '<',
+	RESTRICT = scalargesel,
+	JOIN = scalargejoinsel
+);
+
+CREATE OPERATOR = (
+	LEFTARG = int8,
+	RIGHTARG = duration,
+	PROCEDURE = int8_eq_duration,
+	COMMUTATOR = '=',
+	NEGATOR = '<>',
+	RESTRICT = eqsel,
+	JOIN = eqjoinsel,
+	HASHES
+);
+
+CREATE OPERATOR <> (
+	LEFTARG = int8,
+	RIGHTARG = duration,
+	PROCEDURE = int8_ne_duration,
+	COMMUTATOR = '<>',
+	NEGATOR = '=',
+	RESTRICT = neqsel,
+	JOIN = neqjoinsel
+);
+
+-- The families take only the cross-type operators.  Adding the core int8
+-- operators would make them members of a second btree family, which stops
+-- the planner from combining int8 equalities with those of the other integer
+-- types.  Without the int8 sort operators the family cannot drive a merge
+-- join, so the equality operators are HASHES but not MERGES.
+
+ALTER OPERATOR FAMILY duration_ops USING btree ADD
+    OPERATOR        1       < (duration, int8),
+    OPERATOR        2       <= (duration, int8),
+    OPERATOR        3       = (duration, int8),
+    OPERATOR        4       >= (duration, int8),
+    OPERATOR        5       > (duration, int8),
+    FUNCTION        1       duration_int8_cmp(duration, int8),
+    OPERATOR        1       < (int8, duration),
+    OPERATOR        2       <= (int8, duration),
+    OPERATOR        3       = (int8, duration),
+    OPERATOR        4       >= (int8, duration),
+    OPERATOR        5       > (int8, duration),
+    FUNCTION        1       int8_duration_cmp(int8, duration);
+
+ALTER OPERATOR FAMILY duration_ops USING hash ADD
+    OPERATOR        1       = (duration, int8),
+    OPERATOR        1       = (int8, duration),
+    FUNCTION        1       hashint8(int8),
+    FUNCTION        2       hashint8extended(int8, int8);
+
+-- Create interval comparisons
+
+CREATE FUNCTION duration_interval_cmp(duration, interval)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_interval_cmp(duration, interval) IS 'btree comparison function';
+
+CREATE FUNCTION duration_lt_interval(duration, interval)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_lt_interval(duration, interval) IS
+'less than';
+
+CREATE FUNCTION duration_le_interval(duration, interval)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_le_interval(duration, interval) IS
+'less than or equal';
+
+CREATE FUNCTION duration_gt_interval(duration, interval)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_gt_interval(duration, interval) IS
+'greater than';
+
+CREATE FUNCTION duration_ge_interval(duration, interval)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_ge_interval(duration, interval) IS
+'greater than or equal';
+
+CREATE FUNCTION duration_eq_interval(duration, interval)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_eq_interval(duration, interval) IS
+'equal';
+
+CREATE FUNCTION duration_ne_interval(duration, interval)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_ne_interval(duration, interval) IS
+'not equal';
+
+CREATE FUNCTION interval_duration_cmp(interval, duration)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION interval_duration_cmp(interval, duration) IS 'btree comparison function';
+
+CREATE FUNCTION interval_lt_duration(interval, duration)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION interval_lt_duration(interval, duration) IS
+'less than';
+
+CREATE FUNCTION interval_le_duration(interval, duration)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION interval_le_duration(interval, duration) IS
+'less than or equal';
+
+CREATE FUNCTION interval_gt_duration(interval, duration)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION interval_gt_duration(interval, duration) IS
+'greater than';
+
+CREATE FUNCTION interval_ge_duration(interval, duration)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION interval_ge_duration(interval, duration) IS
+'greater than or equal';
+
+CREATE FUNCTION interval_eq_duration(interval, duration)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION interval_eq_duration(interval, duration) IS
+'equal';
+
+CREATE FUNCTION interval_ne_duration(interval, duration)
+RETURNS bool
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION interval_ne_duration(interval, duration) IS
+'not equal';
+
+CREATE OPERATOR < (
+	LEFTARG = duration,
+	RIGHTARG = interval,
+	PROCEDURE = duration_lt_interval,
+	COMMUTATOR = '>',
+	NEGATOR = '>=',
+	RESTRICT = scalarltsel,
+	JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR <= (
+	LEFTARG = duration,
+	RIGHTARG = interval,
+	PROCEDURE = duration_le_interval,
+	COMMUTATOR = '>=',
+	NEGATOR = '>',
+	RESTRICT = scalarlesel,
+	JOIN = scalarlejoinsel
+);
+
+CREATE OPERATOR > (
+	LEFTARG = duration,
+	RIGHTARG = interval,
+	PROCEDURE = duration_gt_interval,
+	COMMUTATOR = '<',
+	NEGATOR = '<=',
+	RESTRICT = scalargtsel,
+	JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR >= (
+	LEFTARG = duration,
+	RIGHTARG = interval,
+	PROCEDURE = duration_ge_interval,
+	COMMUTATOR = '<=',
+	NEGATOR = '<',
+	RESTRICT = scalargesel,
+	JOIN = scalargejoinsel
+);
+
+CREATE OPERATOR = (
+	LEFTARG = duration,
+	RIGHTARG = interval,
+	PROCEDURE = duration_eq_interval,
+	COMMUTATOR = '=',
+	NEGATOR = '<>',
+	RESTRICT = eqsel,
+	JOIN = eqjoinsel,
+	HASHES
+);
+
+CREATE OPERATOR <> (
+	LEFTARG = duration,
+	RIGHTARG = interval,
+	PROCEDURE = duration_ne_interval,
+	COMMUTATOR = '<>',
+	NEGATOR = '=',
+	RESTRICT = neqsel,
+	JOIN = neqjoinsel
+);
+
+CREATE OPERATOR < (
+	LEFTARG = interval,
+	RIGHTARG = duration,
+	PROCEDURE = interval_lt_duration,
+	COMMUTATOR = '>',
+	NEGATOR = '>=',
+	RESTRICT = scalarltsel,
+	JOIN = scalarltjoinsel
+);
+
+CREATE OPERATOR <= (
+	LEFTARG = interval,
+	RIGHTARG = duration,
+	PROCEDURE = interval_le_duration,
+	COMMUTATOR = '>=',
+	NEGATOR = '>',
+	RESTRICT = scalarlesel,
+	JOIN = scalarlejoinsel
+);
+
+CREATE OPERATOR > (
+	LEFTARG = interval,
+	RIGHTARG = duration,
+	PROCEDURE = interval_gt_duration,
+	COMMUTATOR = '<',
+	NEGATOR = '<=',
+	RESTRICT = scalargtsel,
+	JOIN = scalargtjoinsel
+);
+
+CREATE OPERATOR >= (
+	LEFTARG = interval,
+	RIGHTARG = duration,
+	PROCEDURE = interval_ge_duration,
+	COMMUTATOR = '<=',
+	NEGATOR = '<',
+	RESTRICT = scalargesel,
+	JOIN = scalargejoinsel
+);
+
+CREATE OPERATOR = (
+	LEFTARG = interval,
+	RIGHTARG = duration,
+	PROCEDURE = interval_eq_duration,
+	COMMUTATOR = '=',
+	NEGATOR = '<>',
+	RESTRICT = eqsel,
+	JOIN = eqjoinsel,
+	HASHES
+);
+
+CREATE OPERATOR <> (
+	LEFTARG = interval,
+	RIGHTARG = duration,
+	PROCEDURE = interval_ne_duration,
+	COMMUTATOR = '<>',
+	NEGATOR = '=',
+	RESTRICT = neqsel,
+	JOIN = neqjoinsel
+);
+
+CREATE FUNCTION duration_hash_interval(interval)
+RETURNS int4
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_hash_interval(interval) IS
+'hash interval compatibly with duration';
+
+CREATE FUNCTION duration_hash_interval_extended(interval, int8)
+RETURNS int8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_hash_interval_extended(interval, int8) IS
+'hash interval compatibly with duration, with seed';
+
+-- As with bigint, only the cross-type operators join the families, leaving
+-- the core interval operators in interval_ops alone.  The equality operators
+-- are HASHES but not MERGES for the same reason.
+
+ALTER OPERATOR FAMILY duration_ops USING btree ADD
+    OPERATOR        1       < (duration, interval),
+    OPERATOR        2       <= (duration, interval),
+    OPERATOR        3       = (duration, interval),
+    OPERATOR        4       >= (duration, interval),
+    OPERATOR        5       > (duration, interval),
+    FUNCTION        1       duration_interval_cmp(duration, interval),
+    OPERATOR        1       < (interval, duration),
+    OPERATOR        2       <= (interval, duration),
+    OPERATOR        3       = (interval, duration),
+    OPERATOR        4       >= (interval, duration),
+    OPERATOR        5       > (interval, duration),
+    FUNCTION        1       interval_duration_cmp(interval, duration);
+
+ALTER OPERATOR FAMILY duration_ops USING hash ADD
+    OPERATOR        1       = (duration, interval),
+    OPERATOR        1       = (interval, duration),
+    FUNCTION        1       duration_hash_interval(interval),
+    FUNCTION        2       duration_hash_interval_extended(interval, int8);
+
+-- Create integer arithmetic
+
+CREATE FUNCTION duration_mul_int8(duration, int8)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_mul_int8(duration, int8) IS
+'multiplication';
+
+CREATE FUNCTION int8_mul_duration(int8, duration)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION int8_mul_duration(int8, duration) IS
+'multiplication';
+
+CREATE FUNCTION duration_div_int8(duration, int8)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_div_int8(duration, int8) IS
+'division';
+
+CREATE FUNCTION duration_div_duration(duration, duration)
+RETURNS float8
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_div_duration(duration, duration) IS
+'ratio of two durations';
+
+CREATE FUNCTION div(duration, duration)
+RETURNS int8
+AS 'MODULE_PATHNAME', 'duration_quotient'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION div(duration, duration) IS
+'trunc(x/y)';
+
+CREATE FUNCTION duration_mod(duration, duration)
+RETURNS duration
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION duration_mod(duration, duration) IS
+'modulus';
+
+CREATE OPERATOR * (
+	LEFTARG = duration,
+	RIGHTARG = int8,
+	PROCEDURE = duration_mul_int8,
+	COMMUTATOR = '*'
+);
+
+CREATE OPERATOR * (
+	LEFTARG = int8,
+	RIGHTARG = duration,
+	PROCEDURE = int8_mul_duration,
+	COMMUTATOR = '*'
+);
+
+CREATE OPERATOR / (
+	LEFTARG = duration,
+	RIGHTARG = int8,
+	PROCEDURE = duration_div_int8
+);
+
+CREATE OPERATOR % (
+	LEFTARG = duration,
+	RIGHTARG = duration,
+	PROCEDURE = duration_mod
+);
+
+-- Create statistics
+
+CREATE FUNCTION pg_duration_stats(
+    OUT parse_fast int8,
+    OUT parse_decode int8,
+    OUT parse_iso8601 int8,
+    OUT parse_errors int8,
+    OUT overflow_errors int8,
+    OUT agg_states int8,
+    OUT interval_casts int8,
+    OUT stats_reset timestamptz
+)
+RETURNS record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT VOLATILE;
+
+COMMENT ON FUNCTION pg_duration_stats() IS
+'hot-path counters, see pg_duration.track_stats';
+
+CREATE FUNCTION pg_duration_stats_reset()
+RETURNS void
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT VOLATILE;
+
+COMMENT ON FUNCTION pg_duration_stats_reset() IS
+'reset the hot-path counters';
+
+REVOKE ALL ON FUNCTION pg_duration_stats_reset() FROM PUBLIC;
+
+CREATE VIEW pg_duration_stats AS
+    SELECT * FROM pg_duration_stats();
+
+-- Create compressed series
+
+CREATE TYPE duration_series;
+
+CREATE FUNCTION duration_series_in(cstring)
+RETURNS duration_series
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+CREATE FUNCTION duration_series_out(duration_series)
+RETURNS cstring
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+CREATE FUNCTION duration_series_recv(internal)
+RETURNS duration_series
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+CREATE FUNCTION duration_series_send(duration_series)
+RETURNS bytea
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT IMMUTABLE;
+
+CREATE TYPE duration_series (
+    INTERNALLENGTH = VARIABLE,
+    INPUT = duration_series_in,
+    OUTPUT = duration_series_out,
+    RECEIVE = duration_series_recv,
+    SEND = duration_series_send,
+    ALIGNMENT = double,
+    STORAGE = extended
+);
+
+COMMENT ON TYPE duration_series IS 'compressed sequence of durations';
+
+CREATE FUNCTION duration_series_accum(internal, duration)
+RETURNS internal
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_series_accum(internal, duration) IS
+'duration_series_agg transition function';
+
+CREATE FUNCTION duration_series_final(internal)
+RETURNS duration_series
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE;
+
+COMMENT ON FUNCTION duration_series_final(internal) IS
+'duration_series_agg final function';
+
+CREATE AGGREGATE duration_series_agg(duration)  (
+    SFUNC = duration_series_accum,
+    STYPE = internal,
+    FINALFUNC = duration_series_final
+);
+
+CREATE FUNCTION unnest(duration_series)
+RETURNS SETOF duration
+AS 'MODULE_PATHNAME', 'duration_series_unnest'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION unnest(duration_series) IS
+'expand a duration series to a set of rows';
+
+CREATE FUNCTION series_count(duration_series)
+RETURNS int8
+AS 'MODULE_PATHNAME', 'duration_series_count'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION series_count(duration_series) IS
+'number of values in a duration series';
+
+CREATE FUNCTION series_sum(duration_series)
+RETURNS duration
+AS 'MODULE_PATHNAME', 'duration_series_sum'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION series_sum(duration_series) IS
+'sum of the values in a duration series';
+
+CREATE FUNCTION series_min(duration_series)
+RETURNS duration
+AS 'MODULE_PATHNAME', 'duration_series_min'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION series_min(duration_series) IS
+'smallest value in a duration series';
+
+CREATE FUNCTION series_max(duration_series)
+RETURNS duration
+AS 'MODULE_PATHNAME', 'duration_series_max'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION series_max(duration_series) IS
+'largest value in a duration series';
+
+-- Create array functions
+
+CREATE FUNCTION array_sum(duration[])
+RETURNS duration
+AS 'MODULE_PATHNAME', 'duration_array_sum'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION array_sum(duration[]) IS
+'sum of the non-null elements of a duration array';
+
+CREATE FUNCTION array_avg(duration[])
+RETURNS duration
+AS 'MODULE_PATHNAME', 'duration_array_avg'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION array_avg(duration[]) IS
+'average of the non-null elements of a duration array';
+
+CREATE FUNCTION array_min(duration[])
+RETURNS duration
+AS 'MODULE_PATHNAME', 'duration_array_min'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION array_min(duration[]) IS
+'smallest non-null element of a duration array';
+
+CREATE FUNCTION array_max(duration[])
+RETURNS duration
+AS 'MODULE_PATHNAME', 'duration_array_max'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION array_max(duration[]) IS
+'largest non-null element of a duration array';
+
+CREATE FUNCTION array_sort(duration[])
+RETURNS duration[]
+AS 'MODULE_PATHNAME', 'duration_array_sort'
+LANGUAGE C STRICT IMMUTABLE;
+
+COMMENT ON FUNCTION array_sort(duration[]) IS
+'sort a duration array in ascending order, nulls last';
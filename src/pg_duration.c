@@ -7,16 +7,60 @@
 
 #include "postgres.h"
 
+#include <ctype.h>
 #include <math.h>
 
+/*
+ * The duration[] reductions have AVX2 versions, chosen at run time, on x86-64
+ * compilers that can target AVX2 for single functions.  PostgreSQL 17 has
+ * pg_attribute_target for this; older headers get it here.
+ */
+#if defined(__x86_64__) && defined(__GNUC__) && defined(__has_attribute)
+#if __has_attribute(target)
+#define USE_AVX2_ARRAY_REDUCTIONS
+#include <immintrin.h>
+#ifndef pg_attribute_target
+#define pg_attribute_target(...) __attribute__((target(__VA_ARGS__)))
+#endif
+#endif
+#endif
+
+#include "access/gist.h"
+#include "access/htup_details.h"
+#include "access/stratnum.h"
+#include "access/xact.h"
+#include "catalog/pg_am_d.h"
+#include "catalog/pg_operator_d.h"
+#include "catalog/pg_type_d.h"
 #include "parser/scansup.h"
+#include "port/pg_bitutils.h"
+#include "commands/defrem.h"
 #include "common/int.h"
+#include "common/int128.h"
 #include "fmgr.h"
+#include "funcapi.h"
 #include "libpq/pqformat.h"
 #include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "nodes/miscnodes.h"
+#include "nodes/nodeFuncs.h"
+#include "nodes/supportnodes.h"
+#include "optimizer/optimizer.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "utils/array.h"
+#include "utils/date.h"
 #include "utils/float.h"
 #include "utils/fmgrprotos.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
 #include "utils/numeric.h"
+#include "utils/sortsupport.h"
+#include "utils/timestamp.h"
+#include "utils/tuplesort.h"
 #include "varatt.h"
 
 #include "pg_duration.h"
@@ -35,6 +79,10 @@ PG_FUNCTION_INFO_V1(duration_send);
 ** Indexing routines
 */
 PG_FUNCTION_INFO_V1(hash_duration);
+PG_FUNCTION_INFO_V1(hash_duration_extended);
+PG_FUNCTION_INFO_V1(duration_sortsupport);
+PG_FUNCTION_INFO_V1(duration_minmax_multi_distance);
+PG_FUNCTION_INFO_V1(in_range_duration_duration);
 
 /*
 ** Comparison operators
@@ -46,6 +94,7 @@ PG_FUNCTION_INFO_V1(duration_gt);
 PG_FUNCTION_INFO_V1(duration_ge);
 PG_FUNCTION_INFO_V1(duration_eq);
 PG_FUNCTION_INFO_V1(duration_ne);
+PG_FUNCTION_INFO_V1(duration_cmp_support);
 
 /*
 ** Arithmetic operators
@@ -55,6 +104,34 @@ PG_FUNCTION_INFO_V1(duration_pl);
 PG_FUNCTION_INFO_V1(duration_mi);
 PG_FUNCTION_INFO_V1(duration_mul);
 PG_FUNCTION_INFO_V1(duration_div);
+PG_FUNCTION_INFO_V1(duration_dist);
+
+/*
+** Date/time arithmetic operators
+*/
+PG_FUNCTION_INFO_V1(timestamp_pl_duration);
+PG_FUNCTION_INFO_V1(timestamp_mi_duration);
+PG_FUNCTION_INFO_V1(timestamptz_pl_duration);
+PG_FUNCTION_INFO_V1(timestamptz_mi_duration);
+PG_FUNCTION_INFO_V1(date_pl_duration);
+PG_FUNCTION_INFO_V1(date_mi_duration);
+PG_FUNCTION_INFO_V1(time_pl_duration);
+PG_FUNCTION_INFO_V1(time_mi_duration);
+PG_FUNCTION_INFO_V1(timestamp_diff_duration);
+
+/*
+** GiST support
+*/
+PG_FUNCTION_INFO_V1(gist_durationkey_in);
+PG_FUNCTION_INFO_V1(gist_durationkey_out);
+PG_FUNCTION_INFO_V1(gist_duration_consistent);
+PG_FUNCTION_INFO_V1(gist_duration_union);
+PG_FUNCTION_INFO_V1(gist_duration_compress);
+PG_FUNCTION_INFO_V1(gist_duration_fetch);
+PG_FUNCTION_INFO_V1(gist_duration_penalty);
+PG_FUNCTION_INFO_V1(gist_duration_picksplit);
+PG_FUNCTION_INFO_V1(gist_duration_same);
+PG_FUNCTION_INFO_V1(gist_duration_distance);
 
 /*
 ** Public routines
@@ -62,6 +139,8 @@ PG_FUNCTION_INFO_V1(duration_div);
 PG_FUNCTION_INFO_V1(make_duration);
 PG_FUNCTION_INFO_V1(duration_finite);
 PG_FUNCTION_INFO_V1(duration_trunc);
+PG_FUNCTION_INFO_V1(date_bin_duration);
+PG_FUNCTION_INFO_V1(duration_bin);
 PG_FUNCTION_INFO_V1(duration_part);
 PG_FUNCTION_INFO_V1(extract_duration);
 
@@ -71,18 +150,180 @@ PG_FUNCTION_INFO_V1(extract_duration);
 PG_FUNCTION_INFO_V1(duration_interval);
 PG_FUNCTION_INFO_V1(interval_duration);
 
+/*
+** Range types
+*/
+PG_FUNCTION_INFO_V1(duration_subdiff);
+
 /*
 ** Aggregates
 */
 PG_FUNCTION_INFO_V1(duration_avg_accum);
+PG_FUNCTION_INFO_V1(duration_accum);
 PG_FUNCTION_INFO_V1(duration_avg_combine);
 PG_FUNCTION_INFO_V1(duration_avg_serialize);
 PG_FUNCTION_INFO_V1(duration_avg_deserialize);
 PG_FUNCTION_INFO_V1(duration_avg_accum_inv);
 PG_FUNCTION_INFO_V1(duration_avg);
 PG_FUNCTION_INFO_V1(duration_sum);
+PG_FUNCTION_INFO_V1(duration_var_pop);
+PG_FUNCTION_INFO_V1(duration_var_samp);
+PG_FUNCTION_INFO_V1(duration_stddev_pop);
+PG_FUNCTION_INFO_V1(duration_stddev_samp);
+PG_FUNCTION_INFO_V1(duration_sum_accum);
+PG_FUNCTION_INFO_V1(duration_sum_combine);
+PG_FUNCTION_INFO_V1(duration_sum_serialize);
+PG_FUNCTION_INFO_V1(duration_sum_deserialize);
+PG_FUNCTION_INFO_V1(duration_sum_final);
 PG_FUNCTION_INFO_V1(duration_smaller);
 PG_FUNCTION_INFO_V1(duration_larger);
+PG_FUNCTION_INFO_V1(duration_smaller_accum);
+PG_FUNCTION_INFO_V1(duration_larger_accum);
+PG_FUNCTION_INFO_V1(duration_minmax_accum_inv);
+PG_FUNCTION_INFO_V1(duration_minmax_final);
+
+/*
+** Ordered-set aggregates
+*/
+PG_FUNCTION_INFO_V1(duration_percentile_accum);
+PG_FUNCTION_INFO_V1(duration_percentile_disc_final);
+PG_FUNCTION_INFO_V1(duration_percentile_cont_final);
+PG_FUNCTION_INFO_V1(duration_percentile_disc_multi_final);
+PG_FUNCTION_INFO_V1(duration_percentile_cont_multi_final);
+PG_FUNCTION_INFO_V1(duration_median_final);
+
+/*
+** Quantile sketches
+*/
+PG_FUNCTION_INFO_V1(duration_sketch_in);
+PG_FUNCTION_INFO_V1(duration_sketch_out);
+PG_FUNCTION_INFO_V1(duration_sketch_recv);
+PG_FUNCTION_INFO_V1(duration_sketch_send);
+PG_FUNCTION_INFO_V1(duration_sketch_accum);
+PG_FUNCTION_INFO_V1(duration_sketch_merge_accum);
+PG_FUNCTION_INFO_V1(duration_sketch_combine);
+PG_FUNCTION_INFO_V1(duration_sketch_serialize);
+PG_FUNCTION_INFO_V1(duration_sketch_deserialize);
+PG_FUNCTION_INFO_V1(duration_sketch_final);
+PG_FUNCTION_INFO_V1(duration_sketch_quantile);
+
+/*
+** Histograms
+*/
+PG_FUNCTION_INFO_V1(duration_histogram_accum);
+PG_FUNCTION_INFO_V1(duration_histogram_combine);
+PG_FUNCTION_INFO_V1(duration_histogram_serialize);
+PG_FUNCTION_INFO_V1(duration_histogram_deserialize);
+PG_FUNCTION_INFO_V1(duration_histogram_final);
+
+/*
+** Set-returning functions
+*/
+PG_FUNCTION_INFO_V1(generate_series_duration);
+PG_FUNCTION_INFO_V1(generate_series_timestamptz_duration);
+PG_FUNCTION_INFO_V1(generate_series_duration_support);
+
+/*
+** Bigint conversions and comparisons
+*/
+PG_FUNCTION_INFO_V1(to_duration_nanos);
+PG_FUNCTION_INFO_V1(to_duration_micros);
+PG_FUNCTION_INFO_V1(duration_to_micros);
+PG_FUNCTION_INFO_V1(duration_int8_cmp);
+PG_FUNCTION_INFO_V1(duration_lt_int8);
+PG_FUNCTION_INFO_V1(duration_le_int8);
+PG_FUNCTION_INFO_V1(duration_gt_int8);
+PG_FUNCTION_INFO_V1(duration_ge_int8);
+PG_FUNCTION_INFO_V1(duration_eq_int8);
+PG_FUNCTION_INFO_V1(duration_ne_int8);
+PG_FUNCTION_INFO_V1(int8_duration_cmp);
+PG_FUNCTION_INFO_V1(int8_lt_duration);
+PG_FUNCTION_INFO_V1(int8_le_duration);
+PG_FUNCTION_INFO_V1(int8_gt_duration);
+PG_FUNCTION_INFO_V1(int8_ge_duration);
+PG_FUNCTION_INFO_V1(int8_eq_duration);
+PG_FUNCTION_INFO_V1(int8_ne_duration);
+
+/*
+** Interval comparisons
+*/
+PG_FUNCTION_INFO_V1(duration_interval_cmp);
+PG_FUNCTION_INFO_V1(duration_lt_interval);
+PG_FUNCTION_INFO_V1(duration_le_interval);
+PG_FUNCTION_INFO_V1(duration_gt_interval);
+PG_FUNCTION_INFO_V1(duration_ge_interval);
+PG_FUNCTION_INFO_V1(duration_eq_interval);
+PG_FUNCTION_INFO_V1(duration_ne_interval);
+PG_FUNCTION_INFO_V1(interval_duration_cmp);
+PG_FUNCTION_INFO_V1(interval_lt_duration);
+PG_FUNCTION_INFO_V1(interval_le_duration);
+PG_FUNCTION_INFO_V1(interval_gt_duration);
+PG_FUNCTION_INFO_V1(interval_ge_duration);
+PG_FUNCTION_INFO_V1(interval_eq_duration);
+PG_FUNCTION_INFO_V1(interval_ne_duration);
+PG_FUNCTION_INFO_V1(duration_hash_interval);
+PG_FUNCTION_INFO_V1(duration_hash_interval_extended);
+
+/*
+** Integer arithmetic
+*/
+PG_FUNCTION_INFO_V1(duration_mul_int8);
+PG_FUNCTION_INFO_V1(int8_mul_duration);
+PG_FUNCTION_INFO_V1(duration_div_int8);
+PG_FUNCTION_INFO_V1(duration_div_duration);
+PG_FUNCTION_INFO_V1(duration_quotient);
+PG_FUNCTION_INFO_V1(duration_mod);
+
+/*
+** Statistics
+*/
+PG_FUNCTION_INFO_V1(pg_duration_stats);
+PG_FUNCTION_INFO_V1(pg_duration_stats_reset);
+
+/*
+** Compressed series
+*/
+PG_FUNCTION_INFO_V1(duration_series_in);
+PG_FUNCTION_INFO_V1(duration_series_out);
+PG_FUNCTION_INFO_V1(duration_series_recv);
+PG_FUNCTION_INFO_V1(duration_series_send);
+PG_FUNCTION_INFO_V1(duration_series_accum);
+PG_FUNCTION_INFO_V1(duration_series_final);
+PG_FUNCTION_INFO_V1(duration_series_unnest);
+PG_FUNCTION_INFO_V1(duration_series_count);
+PG_FUNCTION_INFO_V1(duration_series_sum);
+PG_FUNCTION_INFO_V1(duration_series_min);
+PG_FUNCTION_INFO_V1(duration_series_max);
+
+/*
+** Array functions
+*/
+PG_FUNCTION_INFO_V1(duration_array_sum);
+PG_FUNCTION_INFO_V1(duration_array_avg);
+PG_FUNCTION_INFO_V1(duration_array_min);
+PG_FUNCTION_INFO_V1(duration_array_max);
+PG_FUNCTION_INFO_V1(duration_array_sort);
+
+/*
+ * Running sum of finite durations.  Where the compiler has a 128-bit integer
+ * type, the sum can't overflow until the very end, like core's int8 sum().
+ */
+#ifdef HAVE_INT128
+typedef int128 DurationSum;
+#else
+typedef int64 DurationSum;
+#endif
+
+/*
+ * Exact running sum of the squares of finite durations, for the variance
+ * aggregates.  A square takes up to 126 bits, so three 64-bit words (least
+ * significant first) hold the sum of 2^64 of them.  The arithmetic is done
+ * by hand, so it doesn't depend on a 128-bit type.
+ */
+typedef struct DurationSquareSum
+{
+	uint64		w[3];
+} DurationSquareSum;
 
 /*
  * The transition datatype for duration aggregates is declared as internal.
@@ -90,16 +331,73 @@ PG_FUNCTION_INFO_V1(duration_larger);
  */
 typedef struct DurationAggState
 {
+	bool		calcSumX2;		/* if true, calculate sumX2 */
 	int64		N;				/* count of finite durations processed */
-	Duration	sumX;			/* sum of finite durations processed */
+	DurationSum sumX;			/* sum of finite durations processed */
+	DurationSquareSum sumX2;	/* sum of squares of finite durations */
 	/* These counts are *not* included in N!  Use DA_TOTAL_COUNT() as needed */
 	int64		pInfcount;		/* count of +infinity durations */
 	int64		nInfcount;		/* count of -infinity durations */
 } DurationAggState;
 
+#define SWAP_DURATION(a, b) \
+	do { Duration swap_tmp_ = (a); (a) = (b); (b) = swap_tmp_; } while (0)
+
 #define DA_TOTAL_COUNT(da) \
 	((da)->N + (da)->pInfcount + (da)->nInfcount)
 
+/*
+ * The transition state of plain sum().  It doesn't need an inverse, so it
+ * can get by without any counts.
+ */
+typedef struct DurationSumState
+{
+	DurationSum sumX;			/* sum of finite durations processed */
+	bool		pInf;			/* seen a +infinity duration? */
+	bool		nInf;			/* seen a -infinity duration? */
+} DurationSumState;
+
+/*
+ * A GiST key for durations is the closed range of all durations below it in
+ * the tree.  Leaf keys have lower == upper.
+ */
+typedef struct DurationGistKey
+{
+	Duration	lower;
+	Duration	upper;
+} DurationGistKey;
+
+/* Strategy numbers beyond the btree ones, matching btree_gist */
+#define DurationGistNotEqualStrategyNumber	6
+#define DurationGistDistanceStrategyNumber	15
+
+/*
+ * Hot-path counters reported by the pg_duration_stats view.  Each backend
+ * counts into duration_local_stats while pg_duration.track_stats is on, and
+ * adds its counts to shared memory at the end of every transaction when the
+ * library is in shared_preload_libraries.
+ */
+typedef enum DurationStatsCounter
+{
+	DURATION_STATS_PARSE_FAST,	/* duration_in handled by the fast path */
+	DURATION_STATS_PARSE_DECODE,	/* duration_in through DecodeInterval */
+	DURATION_STATS_PARSE_ISO8601,	/* duration_in falling back to ISO 8601 */
+	DURATION_STATS_PARSE_ERROR, /* duration_in rejecting its input */
+	DURATION_STATS_OVERFLOW,	/* duration out of range in + or * */
+	DURATION_STATS_AGG_STATE,	/* aggregate transition states allocated */
+	DURATION_STATS_INTERVAL_CAST,	/* duration cast to interval */
+	DURATION_STATS_NUM_COUNTERS
+} DurationStatsCounter;
+
+static bool duration_track_stats = false;
+static uint64 duration_local_stats[DURATION_STATS_NUM_COUNTERS];
+
+#define DURATION_STATS_INC(counter) \
+	do { \
+		if (duration_track_stats) \
+			duration_local_stats[(counter)]++; \
+	} while (0)
+
 static void EncodeSpecialDuration(const Duration duration, char *str);
 static Duration duration_um_internal(const Duration duration);
 
@@ -107,6 +405,440 @@ static Duration duration_um_internal(const Duration duration);
  * Input/Output methods
  *****************************************************************************/
 
+/*
+ * Fast-path input
+ *
+ * duration_in_fast() recognizes what duration_out emits in each IntervalStyle
+ * plus simple "<number> <unit>" lists, and reproduces exactly the result the
+ * general ParseDateTime/DecodeInterval/DecodeISO8601Interval route would give,
+ * including its floating-point rounding of fractional fields.  Anything it is
+ * not sure about, including every input the general route would reject, makes
+ * it return false so that the caller falls back; hence it never reports
+ * errors itself.
+ */
+
+/* fields already seen, to mimic DecodeInterval's duplicate-unit check */
+#define DFP_HOUR		0x01
+#define DFP_MINUTE		0x02
+#define DFP_SECOND		0x04
+#define DFP_MILLISEC	0x08
+#define DFP_MICROSEC	0x10
+
+typedef struct DurationFastUnit
+{
+	const char *name;
+	int			len;
+	int64		scale;
+	int			mask;
+} DurationFastUnit;
+
+static const DurationFastUnit duration_fast_units[] = {
+	{"h", 1, USECS_PER_HOUR, DFP_HOUR},
+	{"hr", 2, USECS_PER_HOUR, DFP_HOUR},
+	{"hrs", 3, USECS_PER_HOUR, DFP_HOUR},
+	{"hour", 4, USECS_PER_HOUR, DFP_HOUR},
+	{"hours", 5, USECS_PER_HOUR, DFP_HOUR},
+	{"m", 1, USECS_PER_MINUTE, DFP_MINUTE},
+	{"min", 3, USECS_PER_MINUTE, DFP_MINUTE},
+	{"mins", 4, USECS_PER_MINUTE, DFP_MINUTE},
+	{"minute", 6, USECS_PER_MINUTE, DFP_MINUTE},
+	{"minutes", 7, USECS_PER_MINUTE, DFP_MINUTE},
+	{"s", 1, USECS_PER_SEC, DFP_SECOND},
+	{"sec", 3, USECS_PER_SEC, DFP_SECOND},
+	{"secs", 4, USECS_PER_SEC, DFP_SECOND},
+	{"second", 6, USECS_PER_SEC, DFP_SECOND},
+	{"seconds", 7, USECS_PER_SEC, DFP_SECOND},
+	{"ms", 2, INT64CONST(1000), DFP_MILLISEC},
+	{"msec", 4, INT64CONST(1000), DFP_MILLISEC},
+	{"msecs", 5, INT64CONST(1000), DFP_MILLISEC},
+	{"millisecond", 11, INT64CONST(1000), DFP_MILLISEC},
+	{"milliseconds", 12, INT64CONST(1000), DFP_MILLISEC},
+	{"us", 2, INT64CONST(1), DFP_MICROSEC},
+	{"usec", 4, INT64CONST(1), DFP_MICROSEC},
+	{"usecs", 5, INT64CONST(1), DFP_MICROSEC},
+	{"microsecond", 11, INT64CONST(1), DFP_MICROSEC},
+	{"microseconds", 12, INT64CONST(1), DFP_MICROSEC},
+};
+
+static inline bool
+fast_isdigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline const char *
+fast_skip_space(const char *cp)
+{
+	while (isspace((unsigned char) *cp))
+		cp++;
+	return cp;
+}
+
+/*
+ * Read up to maxdigits decimal digits; false if there are none or too many.
+ */
+static inline bool
+fast_parse_digits(const char **cpp, int maxdigits, int64 *val, int *ndigits)
+{
+	const char *cp = *cpp;
+	int64		v = 0;
+	int			n = 0;
+
+	while (fast_isdigit(*cp))
+	{
+		if (++n > maxdigits)
+			return false;
+		v = v * 10 + (*cp++ - '0');
+	}
+	if (n == 0)
+		return false;
+
+	*cpp = cp;
+	*val = v;
+	if (ndigits)
+		*ndigits = n;
+	return true;
+}
+
+/*
+ * strtod() of a short numeric string that is not NUL-terminated, so that
+ * fractions round exactly as ParseFraction and ParseISO8601Number do.
+ */
+static double
+fast_strtod(const char *start, const char *end)
+{
+	char		buf[40];
+	int			len = end - start;
+
+	Assert(len > 0 && len < sizeof(buf));
+	memcpy(buf, start, len);
+	buf[len] = '\0';
+
+	return strtod(buf, NULL);
+}
+
+static const int64 fast_pow10[] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/*
+ * Microseconds in a fraction of ndigits digits of the given unit, if that is
+ * a whole number.  The double arithmetic of AdjustFractMicroseconds() is
+ * then known to land on it exactly, so we can skip strtod().
+ */
+static inline bool
+fast_exact_fract(int64 digits, int ndigits, int64 scale, int64 *fusec)
+{
+	if (ndigits >= lengthof(fast_pow10) || scale % fast_pow10[ndigits] != 0)
+		return false;
+
+	*fusec = digits * (scale / fast_pow10[ndigits]);
+	return true;
+}
+
+/* As AdjustFractMicroseconds() in datetime.c */
+static inline int64
+fast_fract_usecs(double fval, int64 scale)
+{
+	int64		fusec;
+
+	fval *= scale;
+	fusec = (int64) fval;
+	fval -= fusec;
+	fusec += rint(fval);
+
+	return fusec;
+}
+
+/* As AdjustMicroseconds() in datetime.c, but reporting overflow as false */
+static inline bool
+fast_adjust_usecs(int64 val, int64 fusec, int64 scale, int64 *usecs)
+{
+	int64		ival;
+
+	if (pg_mul_s64_overflow(val, scale, &ival))
+		return false;
+
+	if (pg_add_s64_overflow(*usecs, fusec, usecs))
+		return false;
+
+	return !pg_add_s64_overflow(*usecs, ival, usecs);
+}
+
+/*
+ * [+-]H:MM:SS[.ffffff], the postgres and sql_standard output.  Hours are
+ * limited to nine digits, so nothing here can overflow.
+ */
+static bool
+duration_in_fast_time(const char *cp, Duration *result)
+{
+	int64		hour,
+				min,
+				sec,
+				usec = 0;
+	bool		neg = false;
+
+	if (*cp == '-' || *cp == '+')
+		neg = (*cp++ == '-');
+
+	if (!fast_parse_digits(&cp, 9, &hour, NULL) || *cp++ != ':')
+		return false;
+	if (!fast_isdigit(cp[0]) || !fast_isdigit(cp[1]) || cp[2] != ':')
+		return false;
+	min = (cp[0] - '0') * 10 + (cp[1] - '0');
+	cp += 3;
+	if (!fast_isdigit(cp[0]) || !fast_isdigit(cp[1]))
+		return false;
+	sec = (cp[0] - '0') * 10 + (cp[1] - '0');
+	cp += 2;
+
+	/* leap seconds and out-of-range minutes are left to DecodeTime */
+	if (min > 59 || sec > 59)
+		return false;
+
+	if (*cp == '.')
+	{
+		int			ndigits;
+
+		cp++;
+		if (!fast_parse_digits(&cp, 6, &usec, &ndigits))
+			return false;
+		while (ndigits++ < 6)
+			usec *= 10;
+	}
+
+	if (*fast_skip_space(cp) != '\0')
+		return false;
+
+	usec += hour * USECS_PER_HOUR + min * USECS_PER_MINUTE + sec * USECS_PER_SEC;
+	*result = neg ? -usec : usec;
+	return true;
+}
+
+/*
+ * PT[n]H[n]M[n]S, the iso_8601 output.  As in DecodeISO8601Interval, fields
+ * may repeat, and a number with a fraction is split into integral and
+ * fractional parts only after strtod() of the whole.  That double keeps
+ * enough fractional precision for the exact shortcut as long as the integral
+ * part is small.
+ */
+static bool
+duration_in_fast_iso8601(const char *cp, Duration *result)
+{
+	int64		usecs = 0;
+
+	cp += 2;					/* skip "PT" */
+	if (*cp == '\0')
+		return false;
+
+	while (*cp)
+	{
+		const char *start = cp;
+		const char *end;
+		int64		val;
+		int64		digits = 0;
+		int			ndigits = 0;
+		int64		fusec = 0;
+		int64		scale;
+
+		if (*cp == '-')
+			cp++;
+		if (!fast_parse_digits(&cp, 15, &val, NULL))
+			return false;
+
+		if (*cp == '.')
+		{
+			cp++;
+			if (!fast_parse_digits(&cp, 15, &digits, &ndigits))
+				return false;
+		}
+		end = cp;
+
+		switch (*cp++)
+		{
+			case 'H':
+				scale = USECS_PER_HOUR;
+				break;
+			case 'M':
+				scale = USECS_PER_MINUTE;
+				break;
+			case 'S':
+				scale = USECS_PER_SEC;
+				break;
+			default:
+				return false;
+		}
+
+		if (ndigits > 0 &&
+			(val >= 65536 || !fast_exact_fract(digits, ndigits, scale, &fusec)))
+		{
+			double		d = fast_strtod(start, end);
+
+			val = (d >= 0) ? (int64) floor(d) : (int64) -floor(-d);
+			fusec = fast_fract_usecs(d - val, scale);
+		}
+		else if (*start == '-')
+		{
+			val = -val;
+			fusec = -fusec;
+		}
+
+		if (!fast_adjust_usecs(val, fusec, scale, &usecs))
+			return false;
+	}
+
+	*result = usecs;
+	return true;
+}
+
+/*
+ * [@] <number> <unit> [<number> <unit> ...] [ago], the postgres_verbose
+ * output and the usual hand-written forms.  A lone number means seconds.
+ */
+static bool
+duration_in_fast_units(const char *cp, Duration *result)
+{
+	int64		usecs = 0;
+	int			fmask = 0;
+	int			nfields = 0;
+	bool		leading_minus;
+
+	if (*cp == '@')
+		cp = fast_skip_space(cp + 1);
+	leading_minus = (*cp == '-');
+
+	while (*cp)
+	{
+		const char *start = cp;
+		const DurationFastUnit *unit = NULL;
+		const char *frac = NULL;
+		const char *end = NULL;
+		int64		val;
+		int64		digits = 0;
+		int			ndigits = 0;
+		int64		fusec = 0;
+		int64		scale;
+		int			mask;
+
+		if (*cp == '-' || *cp == '+')
+			cp++;
+		if (!fast_parse_digits(&cp, 18, &val, NULL))
+		{
+			/* "ago" must be the last word, and negates everything */
+			if (nfields > 0 && pg_strncasecmp(cp, "ago", 3) == 0 &&
+				*fast_skip_space(cp + 3) == '\0' && usecs != PG_INT64_MIN)
+			{
+				usecs = -usecs;
+				break;
+			}
+			return false;
+		}
+		if (*cp == '.')
+		{
+			frac = cp++;
+			if (!fast_parse_digits(&cp, 15, &digits, &ndigits))
+				return false;
+			end = cp;
+		}
+
+		cp = fast_skip_space(cp);
+		if (isalpha((unsigned char) *cp))
+		{
+			const char *word = cp;
+
+			while (isalpha((unsigned char) *cp))
+				cp++;
+
+			for (int i = 0; i < lengthof(duration_fast_units); i++)
+			{
+				if (duration_fast_units[i].len == cp - word &&
+					pg_strncasecmp(word, duration_fast_units[i].name,
+								   cp - word) == 0)
+				{
+					unit = &duration_fast_units[i];
+					break;
+				}
+			}
+			/* ParseDateTime may glue what follows a unit onto it */
+			if (unit == NULL || (*cp != '\0' && !isspace((unsigned char) *cp)))
+				return false;
+			cp = fast_skip_space(cp);
+			scale = unit->scale;
+			mask = unit->mask;
+		}
+		else
+		{
+			/* a number without a unit is only simple on its own */
+			if (nfields > 0 || *cp != '\0')
+				return false;
+			scale = USECS_PER_SEC;
+			mask = DFP_SECOND;
+		}
+
+		/* subseconds on a seconds field also claim ms and us */
+		if (mask == DFP_SECOND && digits != 0)
+			mask |= DFP_MILLISEC | DFP_MICROSEC;
+		if (fmask & mask)
+			return false;
+		fmask |= mask;
+
+		/* ParseFraction converts the fraction alone, whatever the integer part */
+		if (ndigits > 0 && !fast_exact_fract(digits, ndigits, scale, &fusec))
+			fusec = fast_fract_usecs(fast_strtod(frac, end), scale);
+		if (*start == '-')
+		{
+			val = -val;
+			fusec = -fusec;
+		}
+
+		if (!fast_adjust_usecs(val, fusec, scale, &usecs))
+			return false;
+		nfields++;
+	}
+
+	if (nfields == 0)
+		return false;
+
+	/* sql_standard may spread a leading minus over the other fields */
+	if (leading_minus && nfields > 1 && IntervalStyle == INTSTYLE_SQL_STANDARD)
+		return false;
+
+	*result = usecs;
+	return true;
+}
+
+static bool
+duration_in_fast(const char *str, Duration *result)
+{
+	const char *cp;
+	const char *p;
+	bool		ok;
+
+	/* long inputs may overrun ParseDateTime's work buffer; let it decide */
+	if (strnlen(str, 128) == 128)
+		return false;
+
+	/* DecodeISO8601Interval tolerates no surrounding space */
+	if (str[0] == 'P' && str[1] == 'T')
+		ok = duration_in_fast_iso8601(str, result);
+	else
+	{
+		cp = fast_skip_space(str);
+
+		/* the time form has a colon right after the hours */
+		p = cp + (*cp == '-' || *cp == '+');
+		while (fast_isdigit(*p))
+			p++;
+		if (*p == ':')
+			ok = duration_in_fast_time(cp, result);
+		else
+			ok = duration_in_fast_units(cp, result);
+	}
+
+	/* leave the infinities, spelled out or not, to the general code */
+	return ok && !DURATION_NOT_FINITE(*result);
+}
+
 Datum
 duration_in(PG_FUNCTION_ARGS)
 {
@@ -123,6 +855,13 @@ duration_in(PG_FUNCTION_ARGS)
 	int			ftype[MAXDATEFIELDS];
 	char		workbuf[256];
 	DateTimeErrorExtra extra;
+	DurationStatsCounter parsed_by = DURATION_STATS_PARSE_DECODE;
+
+	if (duration_in_fast(str, &result))
+	{
+		DURATION_STATS_INC(DURATION_STATS_PARSE_FAST);
+		PG_RETURN_DURATION(result);
+	}
 
 	itm_in->tm_year = 0;
 	itm_in->tm_mon = 0;
@@ -139,11 +878,15 @@ duration_in(PG_FUNCTION_ARGS)
 
 	/* if those functions think it's a bad format, try ISO8601 style */
 	if (dterr == DTERR_BAD_FORMAT)
+	{
+		parsed_by = DURATION_STATS_PARSE_ISO8601;
 		dterr = DecodeISO8601Interval(str,
 									  &dtype, itm_in);
+	}
 
 	if (dterr != 0)
 	{
+		DURATION_STATS_INC(DURATION_STATS_PARSE_ERROR);
 		if (dterr == DTERR_FIELD_OVERFLOW)
 			dterr = DTERR_INTERVAL_OVERFLOW;
 		DateTimeParseError(dterr, &extra, str, "duration", escontext);
@@ -154,9 +897,12 @@ duration_in(PG_FUNCTION_ARGS)
 	{
 		case DTK_DELTA:
 			if (itmin2duration(itm_in, &result) != 0)
+			{
+				DURATION_STATS_INC(DURATION_STATS_PARSE_ERROR);
 				ereturn(escontext, (Datum) 0,
 						(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
 						 errmsg("invalid units for duration")));
+			}
 			break;
 
 		case DTK_LATE:
@@ -172,27 +918,271 @@ duration_in(PG_FUNCTION_ARGS)
 				 dtype, str);
 	}
 
+	/* count the input once, by the parser that produced it */
+	DURATION_STATS_INC(parsed_by);
+
 	PG_RETURN_DURATION(result);
 }
 
+/*
+ * Direct output
+ *
+ * EncodeDuration() writes what EncodeInterval() would for the pg_itm of a
+ * finite duration, for every IntervalStyle, but with the length worked out
+ * beforehand so that the result is built in place in a single palloc.
+ * Hours fit in 32 bits (at most 2562047788), the other fields in two
+ * digits, and the fraction in six with trailing zeros dropped.
+ */
+
+static const char duration_digit_pairs[200] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static inline int
+duration_ndigits(uint32 value)
+{
+	int			n = 1;
+
+	while (value >= 10)
+	{
+		value /= 10;
+		n++;
+	}
+	return n;
+}
+
+/* write value as exactly ndigits digits, zero-padded; returns the end */
+static inline char *
+duration_put_digits(char *cp, uint32 value, int ndigits)
+{
+	char	   *end = cp + ndigits;
+	char	   *p = end;
+
+	while (p - cp >= 2)
+	{
+		uint32		r = value % 100;
+
+		value /= 100;
+		p -= 2;
+		memcpy(p, &duration_digit_pairs[r * 2], 2);
+	}
+	if (p > cp)
+		*--p = '0' + value % 10;
+
+	return end;
+}
+
+static inline char *
+duration_put_str(char *cp, const char *str, int len)
+{
+	memcpy(cp, str, len);
+	return cp + len;
+}
+
+/* seconds, then the fraction if any, as AppendSeconds() does */
+static inline char *
+duration_put_seconds(char *cp, uint32 sec, int secdigits,
+					 uint32 frac, int fracdigits)
+{
+	cp = duration_put_digits(cp, sec, secdigits);
+	if (fracdigits > 0)
+	{
+		*cp++ = '.';
+		cp = duration_put_digits(cp, frac, fracdigits);
+	}
+	return cp;
+}
+
+static char *
+EncodeDuration(Duration duration, int style)
+{
+	bool		neg = duration < 0;
+	uint64		abs_usec = neg ? -(uint64) duration : (uint64) duration;
+	uint32		hour,
+				min,
+				sec,
+				frac;
+	int			hourdigits,
+				fracdigits = 0;
+	int			len;
+	char	   *result;
+	char	   *cp;
+
+	Assert(!DURATION_NOT_FINITE(duration));
+
+	hour = (uint32) (abs_usec / USECS_PER_HOUR);
+	abs_usec -= (uint64) hour * USECS_PER_HOUR;
+	min = (uint32) (abs_usec / USECS_PER_MINUTE);
+	abs_usec -= (uint64) min * USECS_PER_MINUTE;
+	sec = (uint32) (abs_usec / USECS_PER_SEC);
+	frac = (uint32) (abs_usec - (uint64) sec * USECS_PER_SEC);
+
+	hourdigits = duration_ndigits(hour);
+	if (frac != 0)
+	{
+		fracdigits = 6;
+		while (frac % 10 == 0)
+		{
+			frac /= 10;
+			fracdigits--;
+		}
+	}
+
+	switch (style)
+	{
+		case INTSTYLE_SQL_STANDARD:
+			/* [-]H:MM:SS[.f] */
+			if (duration == 0)
+				return pstrdup("0");
+
+			len = neg + hourdigits + 6 + (fracdigits ? fracdigits + 1 : 0);
+			cp = result = palloc(len + 1);
+			if (neg)
+				*cp++ = '-';
+			cp = duration_put_digits(cp, hour, hourdigits);
+			*cp++ = ':';
+			cp = duration_put_digits(cp, min, 2);
+			*cp++ = ':';
+			cp = duration_put_seconds(cp, sec, 2, frac, fracdigits);
+			break;
+
+		case INTSTYLE_ISO_8601:
+			/* PT[-nH][-nM][-n[.f]S], every field carrying the sign */
+			{
+				int			mindigits = duration_ndigits(min);
+				int			secdigits = duration_ndigits(sec);
+				bool		has_sec = sec != 0 || frac != 0;
+
+				if (duration == 0)
+					return pstrdup("PT0S");
+
+				len = 2;
+				if (hour != 0)
+					len += neg + hourdigits + 1;
+				if (min != 0)
+					len += neg + mindigits + 1;
+				if (has_sec)
+					len += neg + secdigits + (fracdigits ? fracdigits + 1 : 0) + 1;
+
+				cp = result = palloc(len + 1);
+				cp = duration_put_str(cp, "PT", 2);
+				if (hour != 0)
+				{
+					if (neg)
+						*cp++ = '-';
+					cp = duration_put_digits(cp, hour, hourdigits);
+					*cp++ = 'H';
+				}
+				if (min != 0)
+				{
+					if (neg)
+						*cp++ = '-';
+					cp = duration_put_digits(cp, min, mindigits);
+					*cp++ = 'M';
+				}
+				if (has_sec)
+				{
+					if (neg)
+						*cp++ = '-';
+					cp = duration_put_seconds(cp, sec, secdigits, frac, fracdigits);
+					*cp++ = 'S';
+				}
+			}
+			break;
+
+		case INTSTYLE_POSTGRES:
+			/* [-]HH:MM:SS[.f] */
+			hourdigits = Max(hourdigits, 2);
+			len = neg + hourdigits + 6 + (fracdigits ? fracdigits + 1 : 0);
+			cp = result = palloc(len + 1);
+			if (neg)
+				*cp++ = '-';
+			cp = duration_put_digits(cp, hour, hourdigits);
+			*cp++ = ':';
+			cp = duration_put_digits(cp, min, 2);
+			*cp++ = ':';
+			cp = duration_put_seconds(cp, sec, 2, frac, fracdigits);
+			break;
+
+		case INTSTYLE_POSTGRES_VERBOSE:
+		default:
+			/* @ [n hour[s]] [n min[s]] [n[.f] sec[s]] [ago], or @ 0 */
+			{
+				int			mindigits = duration_ndigits(min);
+				int			secdigits = duration_ndigits(sec);
+				bool		has_sec = sec != 0 || frac != 0;
+
+				len = 1;
+				if (hour != 0)
+					len += 1 + hourdigits + 5 + (hour != 1);
+				if (min != 0)
+					len += 1 + mindigits + 4 + (min != 1);
+				if (has_sec)
+					len += 1 + secdigits + (fracdigits ? fracdigits + 1 : 0) +
+						4 + (sec != 1 || frac != 0);
+				if (duration == 0)
+					len += 2;
+				if (neg)
+					len += 4;
+
+				cp = result = palloc(len + 1);
+				*cp++ = '@';
+				if (hour != 0)
+				{
+					*cp++ = ' ';
+					cp = duration_put_digits(cp, hour, hourdigits);
+					cp = duration_put_str(cp, " hours", hour != 1 ? 6 : 5);
+				}
+				if (min != 0)
+				{
+					*cp++ = ' ';
+					cp = duration_put_digits(cp, min, mindigits);
+					cp = duration_put_str(cp, " mins", min != 1 ? 5 : 4);
+				}
+				if (has_sec)
+				{
+					*cp++ = ' ';
+					cp = duration_put_seconds(cp, sec, secdigits, frac, fracdigits);
+					cp = duration_put_str(cp, " secs",
+										  (sec != 1 || frac != 0) ? 5 : 4);
+				}
+				if (duration == 0)
+					cp = duration_put_str(cp, " 0", 2);
+				if (neg)
+					cp = duration_put_str(cp, " ago", 4);
+			}
+			break;
+	}
+
+	Assert(cp - result == len);
+	*cp = '\0';
+
+	return result;
+}
+
 Datum
 duration_out(PG_FUNCTION_ARGS)
 {
 	Duration	duration = PG_GETARG_DURATION(0);
 	char	   *result;
-	struct pg_itm tt,
-			   *itm = &tt;
 	char		buf[MAXDATELEN + 1];
 
 	if (DURATION_NOT_FINITE(duration))
-		EncodeSpecialDuration(duration, buf);
-	else
 	{
-		duration2itm(duration, itm);
-		EncodeInterval(itm, IntervalStyle, buf);
+		EncodeSpecialDuration(duration, buf);
+		result = pstrdup(buf);
 	}
+	else
+		result = EncodeDuration(duration, IntervalStyle);
 
-	result = pstrdup(buf);
 	PG_RETURN_CSTRING(result);
 }
 
@@ -306,6 +1296,120 @@ hash_duration(PG_FUNCTION_ARGS)
 	return hashint8(fcinfo);
 }
 
+Datum
+hash_duration_extended(PG_FUNCTION_ARGS)
+{
+	return hashint8extended(fcinfo);
+}
+
+#if SIZEOF_DATUM < 8
+/* note: this is used for 64-bit durations only on 32-bit platforms */
+static int
+duration_fastcmp(Datum x, Datum y, SortSupport ssup)
+{
+	Duration	a = DatumGetDuration(x);
+	Duration	b = DatumGetDuration(y);
+
+	if (a < b)
+		return -1;
+	else if (a > b)
+		return 1;
+	else
+		return 0;
+}
+#endif
+
+/*
+ * Sort support for the btree opclass.  A duration is a plain signed int64, so
+ * the core signed datum comparator gives the same ordering as duration_cmp
+ * and lets tuplesort use its specialized qsort routine.
+ */
+Datum
+duration_sortsupport(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+#if SIZEOF_DATUM >= 8
+	ssup->comparator = ssup_datum_signed_cmp;
+#else
+	ssup->comparator = duration_fastcmp;
+#endif
+	PG_RETURN_VOID();
+}
+
+/*
+ * in_range support function for window RANGE frames over durations.
+ *
+ * Computing base +/- offset may overflow, or land on one of the values that
+ * are reserved for infinity.  In either case the true sum lies beyond every
+ * finite duration, but still infinitely precedes +infinity (or follows
+ * -infinity), so we can answer without computing it.
+ */
+Datum
+in_range_duration_duration(PG_FUNCTION_ARGS)
+{
+	Duration	val = PG_GETARG_DURATION(0);
+	Duration	base = PG_GETARG_DURATION(1);
+	Duration	offset = PG_GETARG_DURATION(2);
+	bool		sub = PG_GETARG_BOOL(3);
+	bool		less = PG_GETARG_BOOL(4);
+	Duration	sum;
+
+	if (offset < 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PRECEDING_OR_FOLLOWING_SIZE),
+				 errmsg("invalid preceding or following size in window function")));
+
+	/*
+	 * Deal with cases where both base and offset are infinite, and computing
+	 * base +/- offset would cause an error.  As for float and numeric types,
+	 * we assume that all values infinitely precede +infinity and infinitely
+	 * follow -infinity.  See in_range_float8_float8() for reasoning.
+	 */
+	if (DURATION_IS_NOEND(offset) &&
+		(sub ? DURATION_IS_NOEND(base) : DURATION_IS_NOBEGIN(base)))
+		PG_RETURN_BOOL(true);
+
+	if (DURATION_NOT_FINITE(base))
+		sum = base;
+	else if (DURATION_IS_NOEND(offset))
+	{
+		if (sub)
+			DURATION_NOBEGIN(sum);
+		else
+			DURATION_NOEND(sum);
+	}
+	else if ((sub ? pg_sub_s64_overflow(base, offset, &sum) :
+			  pg_add_s64_overflow(base, offset, &sum)) ||
+			 DURATION_NOT_FINITE(sum))
+	{
+		if (sub)
+			PG_RETURN_BOOL(less ? DURATION_IS_NOBEGIN(val) : !DURATION_IS_NOBEGIN(val));
+		else
+			PG_RETURN_BOOL(less ? !DURATION_IS_NOEND(val) : DURATION_IS_NOEND(val));
+	}
+
+	if (less)
+		PG_RETURN_BOOL(val <= sum);
+	else
+		PG_RETURN_BOOL(val >= sum);
+}
+
+/*
+ * Compute the distance between two duration values, for the BRIN
+ * minmax-multi opclass.  The values are passed in sorted order.
+ */
+Datum
+duration_minmax_multi_distance(PG_FUNCTION_ARGS)
+{
+	Duration	a = PG_GETARG_DURATION(0);
+	Duration	b = PG_GETARG_DURATION(1);
+
+	Assert(a <= b);
+
+	PG_RETURN_FLOAT8((double) b - (double) a);
+}
+
 /*****************************************************************************
  *				   Comparison operators
  *****************************************************************************/
@@ -434,9 +1538,12 @@ finite_duration_pl(const Duration duration1, const Duration duration2)
 	Assert(!DURATION_NOT_FINITE(duration2));
 
 	if (pg_add_s64_overflow(duration1, duration2, &result) || DURATION_NOT_FINITE(result))
+	{
+		DURATION_STATS_INC(DURATION_STATS_OVERFLOW);
 		ereport(ERROR,
 				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
 				 errmsg("duration out of range")));
+	}
 
 	return result;
 }
@@ -596,6 +1703,7 @@ duration_mul(PG_FUNCTION_ARGS)
 	PG_RETURN_DURATION(result);
 
 out_of_range:
+	DURATION_STATS_INC(DURATION_STATS_OVERFLOW);
 	ereport(ERROR,
 			errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
 			errmsg("duration out of range"));
@@ -657,199 +1765,598 @@ out_of_range:
 	PG_RETURN_NULL();			/* keep compiler quiet */
 }
 
+/*
+ * duration_dist - absolute difference between two durations
+ *
+ * This is the "<->" distance operator used for KNN GiST searches.  The
+ * distance to an infinite duration is always +infinity.
+ */
+Datum
+duration_dist(PG_FUNCTION_ARGS)
+{
+	Duration	duration1 = PG_GETARG_DURATION(0);
+	Duration	duration2 = PG_GETARG_DURATION(1);
+	Duration	result;
+
+	if (DURATION_NOT_FINITE(duration1) || DURATION_NOT_FINITE(duration2))
+		DURATION_NOEND(result);
+	else
+	{
+		result = finite_duration_mi(duration1, duration2);
+		if (result < 0)
+			result = duration_um_internal(result);
+	}
+
+	PG_RETURN_DURATION(result);
+}
+
 /*****************************************************************************
- *				   Public routines
+ *				   Date/time arithmetic operators
  *****************************************************************************/
 
 /*
- * make_duration - numeric Duration constructor
+ * Add a duration to a timestamp or timestamptz.  Both are microseconds since
+ * the epoch and a duration has no day or month part, so unlike
+ * timestamp_pl_interval() no calendar math or time zone is involved.
  */
-Datum
-make_duration(PG_FUNCTION_ARGS)
+static Timestamp
+timestamp_pl_duration_internal(Timestamp timestamp, Duration duration)
 {
-	int32		hours = PG_GETARG_INT32(0);
-	int32		mins = PG_GETARG_INT32(1);
-	double		secs = PG_GETARG_FLOAT8(2);
-	Duration	result;
+	Timestamp	result;
 
 	/*
-	 * Reject out-of-range inputs.  We reject any input values that cause
-	 * integer overflow of the corresponding duration fields.
+	 * Handle infinities.
+	 *
+	 * We treat anything that amounts to "infinity - infinity" as an error,
+	 * since the timestamp type has nothing equivalent to NaN.
 	 */
-	if (isinf(secs) || isnan(secs))
-		goto out_of_range;
+	if (DURATION_IS_NOBEGIN(duration))
+	{
+		if (TIMESTAMP_IS_NOEND(timestamp))
+			ereport(ERROR,
+					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+					 errmsg("timestamp out of range")));
+		else
+			TIMESTAMP_NOBEGIN(result);
+	}
+	else if (DURATION_IS_NOEND(duration))
+	{
+		if (TIMESTAMP_IS_NOBEGIN(timestamp))
+			ereport(ERROR,
+					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+					 errmsg("timestamp out of range")));
+		else
+			TIMESTAMP_NOEND(result);
+	}
+	else if (TIMESTAMP_NOT_FINITE(timestamp))
+		result = timestamp;
+	else if (pg_add_s64_overflow(timestamp, duration, &result) ||
+			 !IS_VALID_TIMESTAMP(result))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("timestamp out of range")));
 
-	/* hours and mins -> usecs (cannot overflow 64-bit) */
-	result = hours * USECS_PER_HOUR + mins * USECS_PER_MINUTE;
+	return result;
+}
 
-	/* secs -> usecs */
-	secs = rint(float8_mul(secs, USECS_PER_SEC));
-	if (!FLOAT8_FITS_IN_INT64(secs) ||
-		pg_add_s64_overflow(result, (int64) secs, &result))
-		goto out_of_range;
+Datum
+timestamp_pl_duration(PG_FUNCTION_ARGS)
+{
+	Timestamp	timestamp = PG_GETARG_TIMESTAMP(0);
+	Duration	duration = PG_GETARG_DURATION(1);
 
-	/* make sure that the result is finite */
-	if (DURATION_NOT_FINITE(result))
-		goto out_of_range;
+	PG_RETURN_TIMESTAMP(timestamp_pl_duration_internal(timestamp, duration));
+}
 
-	PG_RETURN_DURATION(result);
+Datum
+timestamp_mi_duration(PG_FUNCTION_ARGS)
+{
+	Timestamp	timestamp = PG_GETARG_TIMESTAMP(0);
+	Duration	duration = PG_GETARG_DURATION(1);
 
-out_of_range:
-	ereport(ERROR,
-			errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
-			errmsg("duration out of range"));
+	duration = duration_um_internal(duration);
+	PG_RETURN_TIMESTAMP(timestamp_pl_duration_internal(timestamp, duration));
+}
 
-	PG_RETURN_NULL();			/* keep compiler quiet */
+Datum
+timestamptz_pl_duration(PG_FUNCTION_ARGS)
+{
+	TimestampTz timestamp = PG_GETARG_TIMESTAMPTZ(0);
+	Duration	duration = PG_GETARG_DURATION(1);
+
+	PG_RETURN_TIMESTAMPTZ(timestamp_pl_duration_internal(timestamp, duration));
 }
 
 Datum
-duration_finite(PG_FUNCTION_ARGS)
+timestamptz_mi_duration(PG_FUNCTION_ARGS)
 {
-	Duration	duration = PG_GETARG_DURATION(0);
+	TimestampTz timestamp = PG_GETARG_TIMESTAMPTZ(0);
+	Duration	duration = PG_GETARG_DURATION(1);
 
-	PG_RETURN_BOOL(!DURATION_NOT_FINITE(duration));
+	duration = duration_um_internal(duration);
+	PG_RETURN_TIMESTAMPTZ(timestamp_pl_duration_internal(timestamp, duration));
 }
 
+/*
+ * date +/- duration.  Like date +/- interval, the result is a timestamp.
+ * Without these, "date + duration" would be ambiguous between the timestamp,
+ * timestamptz and interval variants.
+ */
 Datum
-duration_trunc(PG_FUNCTION_ARGS)
+date_pl_duration(PG_FUNCTION_ARGS)
 {
-	text	   *units = PG_GETARG_TEXT_PP(0);
+	DateADT		date = PG_GETARG_DATEADT(0);
 	Duration	duration = PG_GETARG_DURATION(1);
-	Duration	result;
-	int			type,
-				val;
-	char	   *lowunits;
-	struct pg_itm tt,
-			   *tm = &tt;
+	Timestamp	timestamp;
 
-	lowunits = downcase_truncate_identifier(VARDATA_ANY(units),
-											VARSIZE_ANY_EXHDR(units),
-											false);
+	timestamp = DatumGetTimestamp(DirectFunctionCall1(date_timestamp,
+													  DateADTGetDatum(date)));
+	PG_RETURN_TIMESTAMP(timestamp_pl_duration_internal(timestamp, duration));
+}
 
-	type = DecodeUnits(0, lowunits, &val);
+Datum
+date_mi_duration(PG_FUNCTION_ARGS)
+{
+	DateADT		date = PG_GETARG_DATEADT(0);
+	Duration	duration = PG_GETARG_DURATION(1);
+	Timestamp	timestamp;
 
-	if (type == UNITS)
-	{
-		if (DURATION_NOT_FINITE(duration))
-		{
-			/*
-			 * Errors thrown here for invalid units should exactly match those
-			 * below, else there will be unexpected discrepancies between
-			 * finite- and infinite-input cases.
-			 */
-			switch (val)
-			{
-				case DTK_HOUR:
-				case DTK_MINUTE:
-				case DTK_SECOND:
-				case DTK_MILLISEC:
-				case DTK_MICROSEC:
-					result = duration;
-					PG_RETURN_DURATION(result);
-					break;
+	timestamp = DatumGetTimestamp(DirectFunctionCall1(date_timestamp,
+													  DateADTGetDatum(date)));
+	duration = duration_um_internal(duration);
+	PG_RETURN_TIMESTAMP(timestamp_pl_duration_internal(timestamp, duration));
+}
 
-				default:
-					ereport(ERROR,
-							(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-							 errmsg("unit \"%s\" not supported for type duration",
-									lowunits)));
-					result = 0;
-			}
-		}
+/*
+ * Add a duration to a time, wrapping around midnight like
+ * time_pl_interval().
+ */
+static TimeADT
+time_pl_duration_internal(TimeADT time, Duration duration)
+{
+	TimeADT		result;
 
-		duration2itm(duration, tm);
-		switch (val)
-		{
-			case DTK_HOUR:
-				tm->tm_min = 0;
-				/* FALL THRU */
-			case DTK_MINUTE:
-				tm->tm_sec = 0;
-				/* FALL THRU */
-			case DTK_SECOND:
-				tm->tm_usec = 0;
-				break;
-			case DTK_MILLISEC:
-				tm->tm_usec = (tm->tm_usec / 1000) * 1000;
-				break;
-			case DTK_MICROSEC:
-				break;
+	/* Reduce the duration first, so that the sum can't overflow */
+	result = time + duration % USECS_PER_DAY;
+	result -= result / USECS_PER_DAY * USECS_PER_DAY;
+	if (result < INT64CONST(0))
+		result += USECS_PER_DAY;
 
-			default:
-				ereport(ERROR,
-						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-						 errmsg("unit \"%s\" not supported for type duration",
-								lowunits)));
-		}
+	return result;
+}
 
-		if (itm2duration(tm, &result) != 0)
-			ereport(ERROR,
-					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
-					 errmsg("duration out of range")));
-	}
-	else
-	{
+Datum
+time_pl_duration(PG_FUNCTION_ARGS)
+{
+	TimeADT		time = PG_GETARG_TIMEADT(0);
+	Duration	duration = PG_GETARG_DURATION(1);
+
+	if (DURATION_NOT_FINITE(duration))
 		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-				 errmsg("unit \"%s\" not recognized for type duration",
-						lowunits)));
-	}
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("cannot add infinite duration to time")));
 
-	PG_RETURN_DURATION(result);
+	PG_RETURN_TIMEADT(time_pl_duration_internal(time, duration));
+}
+
+Datum
+time_mi_duration(PG_FUNCTION_ARGS)
+{
+	TimeADT		time = PG_GETARG_TIMEADT(0);
+	Duration	duration = PG_GETARG_DURATION(1);
+
+	if (DURATION_NOT_FINITE(duration))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("cannot subtract infinite duration from time")));
+
+	/* Finite durations can always be negated */
+	PG_RETURN_TIMEADT(time_pl_duration_internal(time, -duration));
 }
 
 /*
- * NonFiniteDurationPart
- *
- *	Used by duration_part when extracting from infinite duration.  Returns
- *	+/-Infinity if that is the appropriate result, otherwise returns zero
- *	(which should be taken as meaning to return NULL).
+ * timestamp_diff_duration - difference between two timestamps as a duration
  *
- *	Errors thrown here for invalid units should exactly match those that
- *	would be thrown in the calling functions, else there will be unexpected
- *	discrepancies between finite- and infinite-input cases.
+ * Unlike timestamp_mi(), the result is never justified into days.  This is
+ * used for both timestamp and timestamptz, which share a representation.
  */
-static float8
-NonFiniteDurationPart(int type, int unit, char *lowunits, bool isNegative)
+Datum
+timestamp_diff_duration(PG_FUNCTION_ARGS)
 {
-	if ((type != UNITS) && (type != RESERV))
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-				 errmsg("unit \"%s\" not recognized for type duration",
-						lowunits)));
+	Timestamp	dt1 = PG_GETARG_TIMESTAMP(0);
+	Timestamp	dt2 = PG_GETARG_TIMESTAMP(1);
+	Duration	result;
 
-	switch (unit)
-	{
-			/* Oscillating units */
-		case DTK_MICROSEC:
-		case DTK_MILLISEC:
-		case DTK_SECOND:
-		case DTK_MINUTE:
-			return 0.0;
+	/*
+	 * Handle infinities.
+	 *
+	 * We treat anything that amounts to "infinity - infinity" as an error,
+	 * since the duration type has nothing equivalent to NaN.
+	 */
+	if (TIMESTAMP_IS_NOBEGIN(dt1))
+	{
+		if (TIMESTAMP_IS_NOBEGIN(dt2))
+			ereport(ERROR,
+					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+					 errmsg("duration out of range")));
+		else
+			DURATION_NOBEGIN(result);
+	}
+	else if (TIMESTAMP_IS_NOEND(dt1))
+	{
+		if (TIMESTAMP_IS_NOEND(dt2))
+			ereport(ERROR,
+					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+					 errmsg("duration out of range")));
+		else
+			DURATION_NOEND(result);
+	}
+	else if (TIMESTAMP_IS_NOBEGIN(dt2))
+		DURATION_NOEND(result);
+	else if (TIMESTAMP_IS_NOEND(dt2))
+		DURATION_NOBEGIN(result);
+	else
+		result = finite_duration_mi(dt1, dt2);
 
-			/* Monotonically-increasing units */
-		case DTK_HOUR:
-		case DTK_EPOCH:
-			if (isNegative)
-				return -get_float8_infinity();
-			else
-				return get_float8_infinity();
+	PG_RETURN_DURATION(result);
+}
+
+/*****************************************************************************
+ *				   GiST support
+ *****************************************************************************/
+
+Datum
+gist_durationkey_in(PG_FUNCTION_ARGS)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("cannot accept a value of type %s", "gist_durationkey")));
+
+	PG_RETURN_VOID();			/* keep compiler quiet */
+}
+
+Datum
+gist_durationkey_out(PG_FUNCTION_ARGS)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("cannot display a value of type %s", "gist_durationkey")));
+
+	PG_RETURN_VOID();			/* keep compiler quiet */
+}
+
+/*
+ * Distance from query to the closest duration covered by key, as a float8.
+ * Zero if the key covers the query.
+ */
+static float8
+gist_duration_key_distance(const DurationGistKey *key, Duration query)
+{
+	Duration	closest;
+
+	/* Every distance to an infinite query is infinite */
+	if (DURATION_NOT_FINITE(query))
+		return get_float8_infinity();
+
+	if (query < key->lower)
+		closest = key->lower;
+	else if (query > key->upper)
+		closest = key->upper;
+	else
+		return 0.0;
+
+	if (DURATION_NOT_FINITE(closest))
+		return get_float8_infinity();
+
+	return fabs((float8) query - (float8) closest);
+}
+
+Datum
+gist_duration_consistent(PG_FUNCTION_ARGS)
+{
+	GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+	Duration	query = PG_GETARG_DURATION(1);
+	StrategyNumber strategy = (StrategyNumber) PG_GETARG_UINT16(2);
+
+	/* Oid		subtype = PG_GETARG_OID(3); */
+	bool	   *recheck = (bool *) PG_GETARG_POINTER(4);
+	DurationGistKey *key = (DurationGistKey *) DatumGetPointer(entry->key);
+	bool		result;
 
+	/* All cases served by this function are exact */
+	*recheck = false;
+
+	/*
+	 * Leaf keys have lower == upper, so the same tests work for both leaf and
+	 * internal pages.
+	 */
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+			result = key->lower < query;
+			break;
+		case BTLessEqualStrategyNumber:
+			result = key->lower <= query;
+			break;
+		case BTEqualStrategyNumber:
+			result = key->lower <= query && query <= key->upper;
+			break;
+		case BTGreaterEqualStrategyNumber:
+			result = key->upper >= query;
+			break;
+		case BTGreaterStrategyNumber:
+			result = key->upper > query;
+			break;
+		case DurationGistNotEqualStrategyNumber:
+			result = !(key->lower == query && key->upper == query);
+			break;
 		default:
-			ereport(ERROR,
-					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-					 errmsg("unit \"%s\" not supported for type duration",
-							lowunits)));
-			return 0.0;			/* keep compiler quiet */
+			elog(ERROR, "unrecognized strategy number: %d", strategy);
+			result = false;		/* keep compiler quiet */
 	}
+
+	PG_RETURN_BOOL(result);
 }
 
-static Datum
-duration_part_common(PG_FUNCTION_ARGS, bool retnumeric)
+Datum
+gist_duration_union(PG_FUNCTION_ARGS)
+{
+	GistEntryVector *entryvec = (GistEntryVector *) PG_GETARG_POINTER(0);
+	int		   *sizep = (int *) PG_GETARG_POINTER(1);
+	DurationGistKey *result;
+	DurationGistKey *cur;
+	int			i;
+
+	result = (DurationGistKey *) palloc(sizeof(DurationGistKey));
+	cur = (DurationGistKey *) DatumGetPointer(entryvec->vector[0].key);
+	*result = *cur;
+
+	for (i = 1; i < entryvec->n; i++)
+	{
+		cur = (DurationGistKey *) DatumGetPointer(entryvec->vector[i].key);
+		if (cur->lower < result->lower)
+			result->lower = cur->lower;
+		if (cur->upper > result->upper)
+			result->upper = cur->upper;
+	}
+
+	*sizep = sizeof(DurationGistKey);
+	PG_RETURN_POINTER(result);
+}
+
+Datum
+gist_duration_compress(PG_FUNCTION_ARGS)
+{
+	GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+	GISTENTRY  *retval;
+
+	if (entry->leafkey)
+	{
+		DurationGistKey *key = (DurationGistKey *) palloc(sizeof(DurationGistKey));
+
+		key->lower = key->upper = DatumGetDuration(entry->key);
+
+		retval = (GISTENTRY *) palloc(sizeof(GISTENTRY));
+		gistentryinit(*retval, PointerGetDatum(key),
+					  entry->rel, entry->page, entry->offset, false);
+	}
+	else
+		retval = entry;
+
+	PG_RETURN_POINTER(retval);
+}
+
+/*
+ * Return the original duration of a leaf key, for index-only scans.
+ */
+Datum
+gist_duration_fetch(PG_FUNCTION_ARGS)
+{
+	GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+	DurationGistKey *key = (DurationGistKey *) DatumGetPointer(entry->key);
+	GISTENTRY  *retval;
+
+	retval = (GISTENTRY *) palloc(sizeof(GISTENTRY));
+	gistentryinit(*retval, DurationGetDatum(key->lower),
+				  entry->rel, entry->page, entry->offset, false);
+
+	PG_RETURN_POINTER(retval);
+}
+
+/*
+ * The penalty is how far the original key has to be stretched to cover the
+ * new one.  Computed in float8 so that infinite bounds can't overflow.
+ */
+Datum
+gist_duration_penalty(PG_FUNCTION_ARGS)
+{
+	GISTENTRY  *origentry = (GISTENTRY *) PG_GETARG_POINTER(0);
+	GISTENTRY  *newentry = (GISTENTRY *) PG_GETARG_POINTER(1);
+	float	   *result = (float *) PG_GETARG_POINTER(2);
+	DurationGistKey *orig = (DurationGistKey *) DatumGetPointer(origentry->key);
+	DurationGistKey *newkey = (DurationGistKey *) DatumGetPointer(newentry->key);
+	float8		penalty = 0.0;
+
+	if (newkey->lower < orig->lower)
+		penalty += (float8) orig->lower - (float8) newkey->lower;
+	if (newkey->upper > orig->upper)
+		penalty += (float8) newkey->upper - (float8) orig->upper;
+
+	*result = (float) penalty;
+	PG_RETURN_POINTER(result);
+}
+
+typedef struct
+{
+	OffsetNumber offset;
+	DurationGistKey *key;
+} DurationGistSplitItem;
+
+static int
+gist_duration_split_cmp(const void *a, const void *b)
+{
+	const DurationGistKey *ka = ((const DurationGistSplitItem *) a)->key;
+	const DurationGistKey *kb = ((const DurationGistSplitItem *) b)->key;
+
+	if (ka->lower != kb->lower)
+		return ka->lower < kb->lower ? -1 : 1;
+	if (ka->upper != kb->upper)
+		return ka->upper < kb->upper ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Sort the entries by their lower bound and give each side half of them.
+ */
+Datum
+gist_duration_picksplit(PG_FUNCTION_ARGS)
+{
+	GistEntryVector *entryvec = (GistEntryVector *) PG_GETARG_POINTER(0);
+	GIST_SPLITVEC *v = (GIST_SPLITVEC *) PG_GETARG_POINTER(1);
+	OffsetNumber maxoff = entryvec->n - 1;
+	int			nitems = maxoff - FirstOffsetNumber + 1;
+	DurationGistSplitItem *items;
+	DurationGistKey *left;
+	DurationGistKey *right;
+	OffsetNumber i;
+
+	items = (DurationGistSplitItem *) palloc(nitems * sizeof(DurationGistSplitItem));
+	for (i = FirstOffsetNumber; i <= maxoff; i = OffsetNumberNext(i))
+	{
+		items[i - FirstOffsetNumber].offset = i;
+		items[i - FirstOffsetNumber].key =
+			(DurationGistKey *) DatumGetPointer(entryvec->vector[i].key);
+	}
+	qsort(items, nitems, sizeof(DurationGistSplitItem), gist_duration_split_cmp);
+
+	v->spl_left = (OffsetNumber *) palloc(nitems * sizeof(OffsetNumber));
+	v->spl_right = (OffsetNumber *) palloc(nitems * sizeof(OffsetNumber));
+	v->spl_nleft = 0;
+	v->spl_nright = 0;
+
+	left = (DurationGistKey *) palloc(sizeof(DurationGistKey));
+	right = (DurationGistKey *) palloc(sizeof(DurationGistKey));
+	*left = *items[0].key;
+	*right = *items[nitems - 1].key;
+
+	for (int j = 0; j < nitems; j++)
+	{
+		DurationGistKey *cur = items[j].key;
+		DurationGistKey *side;
+
+		if (j < nitems / 2)
+		{
+			v->spl_left[v->spl_nleft++] = items[j].offset;
+			side = left;
+		}
+		else
+		{
+			v->spl_right[v->spl_nright++] = items[j].offset;
+			side = right;
+		}
+
+		if (cur->lower < side->lower)
+			side->lower = cur->lower;
+		if (cur->upper > side->upper)
+			side->upper = cur->upper;
+	}
+
+	v->spl_ldatum = PointerGetDatum(left);
+	v->spl_rdatum = PointerGetDatum(right);
+
+	PG_RETURN_POINTER(v);
+}
+
+Datum
+gist_duration_same(PG_FUNCTION_ARGS)
+{
+	DurationGistKey *a = (DurationGistKey *) PG_GETARG_POINTER(0);
+	DurationGistKey *b = (DurationGistKey *) PG_GETARG_POINTER(1);
+	bool	   *result = (bool *) PG_GETARG_POINTER(2);
+
+	*result = a->lower == b->lower && a->upper == b->upper;
+	PG_RETURN_POINTER(result);
+}
+
+/*
+ * KNN distance support.  On leaf pages this is exactly the "<->" operator,
+ * on internal pages it is a lower bound for every leaf below.
+ */
+Datum
+gist_duration_distance(PG_FUNCTION_ARGS)
+{
+	GISTENTRY  *entry = (GISTENTRY *) PG_GETARG_POINTER(0);
+	Duration	query = PG_GETARG_DURATION(1);
+
+	/* StrategyNumber strategy = (StrategyNumber) PG_GETARG_UINT16(2); */
+	/* Oid		subtype = PG_GETARG_OID(3); */
+	bool	   *recheck = (bool *) PG_GETARG_POINTER(4);
+	DurationGistKey *key = (DurationGistKey *) DatumGetPointer(entry->key);
+
+	*recheck = false;
+
+	PG_RETURN_FLOAT8(gist_duration_key_distance(key, query));
+}
+
+/*****************************************************************************
+ *				   Public routines
+ *****************************************************************************/
+
+/*
+ * make_duration - numeric Duration constructor
+ */
+Datum
+make_duration(PG_FUNCTION_ARGS)
+{
+	int32		hours = PG_GETARG_INT32(0);
+	int32		mins = PG_GETARG_INT32(1);
+	double		secs = PG_GETARG_FLOAT8(2);
+	Duration	result;
+
+	/*
+	 * Reject out-of-range inputs.  We reject any input values that cause
+	 * integer overflow of the corresponding duration fields.
+	 */
+	if (isinf(secs) || isnan(secs))
+		goto out_of_range;
+
+	/* hours and mins -> usecs (cannot overflow 64-bit) */
+	result = hours * USECS_PER_HOUR + mins * USECS_PER_MINUTE;
+
+	/* secs -> usecs */
+	secs = rint(float8_mul(secs, USECS_PER_SEC));
+	if (!FLOAT8_FITS_IN_INT64(secs) ||
+		pg_add_s64_overflow(result, (int64) secs, &result))
+		goto out_of_range;
+
+	/* make sure that the result is finite */
+	if (DURATION_NOT_FINITE(result))
+		goto out_of_range;
+
+	PG_RETURN_DURATION(result);
+
+out_of_range:
+	ereport(ERROR,
+			errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+			errmsg("duration out of range"));
+
+	PG_RETURN_NULL();			/* keep compiler quiet */
+}
+
+Datum
+duration_finite(PG_FUNCTION_ARGS)
+{
+	Duration	duration = PG_GETARG_DURATION(0);
+
+	PG_RETURN_BOOL(!DURATION_NOT_FINITE(duration));
+}
+
+Datum
+duration_trunc(PG_FUNCTION_ARGS)
 {
 	text	   *units = PG_GETARG_TEXT_PP(0);
 	Duration	duration = PG_GETARG_DURATION(1);
-	int64		intresult;
+	Duration	result;
 	int			type,
 				val;
 	char	   *lowunits;
@@ -861,530 +2368,5568 @@ duration_part_common(PG_FUNCTION_ARGS, bool retnumeric)
 											false);
 
 	type = DecodeUnits(0, lowunits, &val);
-	if (type == UNKNOWN_FIELD)
-		type = DecodeSpecial(0, lowunits, &val);
 
-	if (DURATION_NOT_FINITE(duration))
+	if (type == UNITS)
 	{
-		double		r = NonFiniteDurationPart(type, val, lowunits,
-											  DURATION_IS_NOBEGIN(duration));
-
-		if (r != 0.0)
+		if (DURATION_NOT_FINITE(duration))
 		{
-			if (retnumeric)
+			/*
+			 * Errors thrown here for invalid units should exactly match those
+			 * below, else there will be unexpected discrepancies between
+			 * finite- and infinite-input cases.
+			 */
+			switch (val)
 			{
-				if (r < 0)
-					return DirectFunctionCall3(numeric_in,
-											   CStringGetDatum("-Infinity"),
-											   ObjectIdGetDatum(InvalidOid),
-											   Int32GetDatum(-1));
-				else if (r > 0)
-					return DirectFunctionCall3(numeric_in,
-											   CStringGetDatum("Infinity"),
-											   ObjectIdGetDatum(InvalidOid),
-											   Int32GetDatum(-1));
-			}
-			else
-				PG_RETURN_FLOAT8(r);
-		}
-		else
-			PG_RETURN_NULL();
-	}
+				case DTK_HOUR:
+				case DTK_MINUTE:
+				case DTK_SECOND:
+				case DTK_MILLISEC:
+				case DTK_MICROSEC:
+					result = duration;
+					PG_RETURN_DURATION(result);
+					break;
+
+				default:
+					ereport(ERROR,
+							(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+							 errmsg("unit \"%s\" not supported for type duration",
+									lowunits)));
+					result = 0;
+			}
+		}
+
+		duration2itm(duration, tm);
+		switch (val)
+		{
+			case DTK_HOUR:
+				tm->tm_min = 0;
+				/* FALL THRU */
+			case DTK_MINUTE:
+				tm->tm_sec = 0;
+				/* FALL THRU */
+			case DTK_SECOND:
+				tm->tm_usec = 0;
+				break;
+			case DTK_MILLISEC:
+				tm->tm_usec = (tm->tm_usec / 1000) * 1000;
+				break;
+			case DTK_MICROSEC:
+				break;
+
+			default:
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("unit \"%s\" not supported for type duration",
+								lowunits)));
+		}
+
+		if (itm2duration(tm, &result) != 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+					 errmsg("duration out of range")));
+	}
+	else
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("unit \"%s\" not recognized for type duration",
+						lowunits)));
+	}
+
+	PG_RETURN_DURATION(result);
+}
+
+/*
+ * duration_bin_internal
+ *
+ *	Bin "value" into the stride-wide bucket aligned with "origin", rounding
+ *	towards -infinity.  Shared by date_bin and duration_bin, which only
+ *	differ in how they validate the origin and the result.
+ */
+static int64
+duration_bin_internal(Duration stride, int64 value, int64 origin)
+{
+	int64		diff,
+				modulo,
+				result;
+
+	if (DURATION_NOT_FINITE(stride))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("values cannot be binned into infinite durations")));
+
+	if (stride <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("stride must be greater than zero")));
+
+	if (unlikely(pg_sub_s64_overflow(value, origin, &diff)))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
+
+	/* These calculations cannot overflow */
+	modulo = diff % stride;
+	result = origin + (diff - modulo);
+
+	/*
+	 * We want to round towards -infinity, not 0, when diff is negative and
+	 * not a multiple of stride.  Only this step can leave the valid range.
+	 */
+	if (modulo < 0 &&
+		unlikely(pg_sub_s64_overflow(result, stride, &result)))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
+
+	return result;
+}
+
+/*
+ * date_bin_duration - bin a timestamp(tz) into a fixed-width bucket
+ *
+ * Unlike date_bin(interval, ...), the stride is a plain microsecond count,
+ * so there are no month or day fields to reject.  Timestamps and
+ * timestamptzs share the same representation, so one function serves both.
+ */
+Datum
+date_bin_duration(PG_FUNCTION_ARGS)
+{
+	Duration	stride = PG_GETARG_DURATION(0);
+	TimestampTz timestamp = PG_GETARG_TIMESTAMPTZ(1);
+	TimestampTz origin = PG_GETARG_TIMESTAMPTZ(2);
+	TimestampTz result;
+
+	if (TIMESTAMP_NOT_FINITE(timestamp))
+		PG_RETURN_TIMESTAMPTZ(timestamp);
+
+	if (TIMESTAMP_NOT_FINITE(origin))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("origin out of range")));
+
+	result = duration_bin_internal(stride, timestamp, origin);
+
+	if (!IS_VALID_TIMESTAMP(result))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("timestamp out of range")));
+
+	PG_RETURN_TIMESTAMPTZ(result);
+}
+
+/*
+ * duration_bin - bin a duration into a fixed-width bucket
+ *
+ * The two-argument form aligns buckets with zero.
+ */
+Datum
+duration_bin(PG_FUNCTION_ARGS)
+{
+	Duration	stride = PG_GETARG_DURATION(0);
+	Duration	duration = PG_GETARG_DURATION(1);
+	Duration	origin = PG_NARGS() > 2 ? PG_GETARG_DURATION(2) : 0;
+	Duration	result;
+
+	if (DURATION_NOT_FINITE(duration))
+		PG_RETURN_DURATION(duration);
+
+	if (DURATION_NOT_FINITE(origin))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("origin out of range")));
+
+	result = duration_bin_internal(stride, duration, origin);
+
+	/* landing on a sentinel would silently turn the bucket infinite */
+	if (DURATION_NOT_FINITE(result))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
+
+	PG_RETURN_DURATION(result);
+}
+
+/*
+ * NonFiniteDurationPart
+ *
+ *	Used by duration_part when extracting from infinite duration.  Returns
+ *	+/-Infinity if that is the appropriate result, otherwise returns zero
+ *	(which should be taken as meaning to return NULL).
+ *
+ *	Errors thrown here for invalid units should exactly match those that
+ *	would be thrown in the calling functions, else there will be unexpected
+ *	discrepancies between finite- and infinite-input cases.
+ */
+static float8
+NonFiniteDurationPart(int type, int unit, char *lowunits, bool isNegative)
+{
+	if ((type != UNITS) && (type != RESERV))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("unit \"%s\" not recognized for type duration",
+						lowunits)));
+
+	switch (unit)
+	{
+			/* Oscillating units */
+		case DTK_MICROSEC:
+		case DTK_MILLISEC:
+		case DTK_SECOND:
+		case DTK_MINUTE:
+			return 0.0;
+
+			/* Monotonically-increasing units */
+		case DTK_HOUR:
+		case DTK_EPOCH:
+			if (isNegative)
+				return -get_float8_infinity();
+			else
+				return get_float8_infinity();
+
+		default:
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("unit \"%s\" not supported for type duration",
+							lowunits)));
+			return 0.0;			/* keep compiler quiet */
+	}
+}
+
+static Datum
+duration_part_common(PG_FUNCTION_ARGS, bool retnumeric)
+{
+	text	   *units = PG_GETARG_TEXT_PP(0);
+	Duration	duration = PG_GETARG_DURATION(1);
+	int64		intresult;
+	int			type,
+				val;
+	char	   *lowunits;
+	struct pg_itm tt,
+			   *tm = &tt;
+
+	lowunits = downcase_truncate_identifier(VARDATA_ANY(units),
+											VARSIZE_ANY_EXHDR(units),
+											false);
+
+	type = DecodeUnits(0, lowunits, &val);
+	if (type == UNKNOWN_FIELD)
+		type = DecodeSpecial(0, lowunits, &val);
+
+	if (DURATION_NOT_FINITE(duration))
+	{
+		double		r = NonFiniteDurationPart(type, val, lowunits,
+											  DURATION_IS_NOBEGIN(duration));
+
+		if (r != 0.0)
+		{
+			if (retnumeric)
+			{
+				if (r < 0)
+					return DirectFunctionCall3(numeric_in,
+											   CStringGetDatum("-Infinity"),
+											   ObjectIdGetDatum(InvalidOid),
+											   Int32GetDatum(-1));
+				else if (r > 0)
+					return DirectFunctionCall3(numeric_in,
+											   CStringGetDatum("Infinity"),
+											   ObjectIdGetDatum(InvalidOid),
+											   Int32GetDatum(-1));
+			}
+			else
+				PG_RETURN_FLOAT8(r);
+		}
+		else
+			PG_RETURN_NULL();
+	}
+
+	if (type == UNITS)
+	{
+		duration2itm(duration, tm);
+		switch (val)
+		{
+			case DTK_MICROSEC:
+				intresult = tm->tm_sec * INT64CONST(1000000) + tm->tm_usec;
+				break;
+
+			case DTK_MILLISEC:
+				if (retnumeric)
+					/*---
+					 * tm->tm_sec * 1000 + fsec / 1000
+					 * = (tm->tm_sec * 1'000'000 + fsec) / 1000
+					 */
+					PG_RETURN_NUMERIC(int64_div_fast_to_numeric(tm->tm_sec * INT64CONST(1000000) + tm->tm_usec, 3));
+				else
+					PG_RETURN_FLOAT8(tm->tm_sec * 1000.0 + tm->tm_usec / 1000.0);
+				break;
+
+			case DTK_SECOND:
+				if (retnumeric)
+					/*---
+					 * tm->tm_sec + fsec / 1'000'000
+					 * = (tm->tm_sec * 1'000'000 + fsec) / 1'000'000
+					 */
+					PG_RETURN_NUMERIC(int64_div_fast_to_numeric(tm->tm_sec * INT64CONST(1000000) + tm->tm_usec, 6));
+				else
+					PG_RETURN_FLOAT8(tm->tm_sec + tm->tm_usec / 1000000.0);
+				break;
+
+			case DTK_MINUTE:
+				intresult = tm->tm_min;
+				break;
+
+			case DTK_HOUR:
+				intresult = tm->tm_hour;
+				break;
+
+			default:
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("unit \"%s\" not supported for type duration",
+								lowunits)));
+				intresult = 0;
+		}
+	}
+	else if (type == RESERV && val == DTK_EPOCH)
+	{
+		if (retnumeric)
+		{
+			Numeric		result;
+
+			result = int64_div_fast_to_numeric(duration, 6);
+
+			PG_RETURN_NUMERIC(result);
+		}
+		else
+		{
+			float8		result;
+
+			result = duration / 1000000.0;
+
+			PG_RETURN_FLOAT8(result);
+		}
+	}
+	else
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("unit \"%s\" not recognized for type duration",
+						lowunits)));
+		intresult = 0;
+	}
+
+	if (retnumeric)
+		PG_RETURN_NUMERIC(int64_to_numeric(intresult));
+	else
+		PG_RETURN_FLOAT8(intresult);
+}
+
+Datum
+duration_part(PG_FUNCTION_ARGS)
+{
+	return duration_part_common(fcinfo, false);
+}
+
+Datum
+extract_duration(PG_FUNCTION_ARGS)
+{
+	return duration_part_common(fcinfo, true);
+}
+
+/*****************************************************************************
+ *				   Casts
+ *****************************************************************************/
+
+Datum
+duration_interval(PG_FUNCTION_ARGS)
+{
+	Duration	duration = PG_GETARG_DURATION(0);
+	Interval   *result;
+
+	DURATION_STATS_INC(DURATION_STATS_INTERVAL_CAST);
+
+	result = (Interval *) palloc(sizeof(Interval));
+
+	if (DURATION_IS_NOBEGIN(duration))
+	{
+		INTERVAL_NOBEGIN(result);
+	}
+	else if (DURATION_IS_NOEND(duration))
+	{
+		INTERVAL_NOEND(result);
+	}
+	else
+	{
+		result->time = duration;
+		result->day = 0;
+		result->month = 0;
+	}
+
+	PG_RETURN_INTERVAL_P(result);
+}
+
+Datum
+interval_duration(PG_FUNCTION_ARGS)
+{
+	Interval   *interval = PG_GETARG_INTERVAL_P(0);
+	struct Node *escontext = fcinfo->context;
+	Duration	result;
+
+	if (INTERVAL_IS_NOBEGIN(interval))
+	{
+		DURATION_NOBEGIN(result);
+	}
+	else if (INTERVAL_IS_NOEND(interval))
+	{
+		DURATION_NOEND(result);
+	}
+	else if (interval->month != 0 || interval->day != 0)
+	{
+		ereturn(escontext, (Datum) 0,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("invalid units for duration")));
+	}
+	else
+	{
+		result = interval->time;
+	}
+
+	PG_RETURN_DURATION(result);
+}
+
+/*****************************************************************************
+ *				   Range types
+ *****************************************************************************/
+
+/*
+ * subtype_diff for durationrange, in seconds like tsrange_subdiff.  Computed
+ * in float8 so that the difference can't overflow.
+ */
+Datum
+duration_subdiff(PG_FUNCTION_ARGS)
+{
+	Duration	duration1 = PG_GETARG_DURATION(0);
+	Duration	duration2 = PG_GETARG_DURATION(1);
+	float8		result;
+
+	result = ((float8) duration1 - (float8) duration2) / USECS_PER_SEC;
+	PG_RETURN_FLOAT8(result);
+}
+
+/*****************************************************************************
+ *				   Aggregates
+ *****************************************************************************/
+
+/*
+ * Prepare state data for a duration aggregate function, that needs to compute
+ * sum and count, in the aggregate's memory context.
+ *
+ * The function is used when the state data needs to be allocated in aggregate's
+ * context. When the state data needs to be allocated in the current memory
+ * context, we use palloc0 directly e.g. duration_avg_deserialize().
+ */
+static DurationAggState *
+makeDurationAggState(FunctionCallInfo fcinfo, bool calcSumX2)
+{
+	DurationAggState *state;
+	MemoryContext agg_context;
+	MemoryContext old_context;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	DURATION_STATS_INC(DURATION_STATS_AGG_STATE);
+
+	old_context = MemoryContextSwitchTo(agg_context);
+
+	state = (DurationAggState *) palloc0(sizeof(DurationAggState));
+	state->calcSumX2 = calcSumX2;
+
+	MemoryContextSwitchTo(old_context);
+
+	return state;
+}
+
+/*
+ * Same as makeDurationAggState(), for the sum-only state.
+ */
+static DurationSumState *
+makeDurationSumState(FunctionCallInfo fcinfo)
+{
+	DurationSumState *state;
+	MemoryContext agg_context;
+	MemoryContext old_context;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	DURATION_STATS_INC(DURATION_STATS_AGG_STATE);
+
+	old_context = MemoryContextSwitchTo(agg_context);
+
+	state = (DurationSumState *) palloc0(sizeof(DurationSumState));
+
+	MemoryContextSwitchTo(old_context);
+
+	return state;
+}
+
+/*
+ * Add or subtract a finite duration to or from a running sum.  With a 128-bit
+ * accumulator this can't overflow for any realistic number of inputs; range
+ * checking is deferred to duration_sum_result().
+ */
+static inline void
+duration_sum_add(DurationSum *sum, Duration val)
+{
+#ifdef HAVE_INT128
+	*sum += val;
+#else
+	*sum = finite_duration_pl(*sum, val);
+#endif
+}
+
+static inline void
+duration_sum_sub(DurationSum *sum, Duration val)
+{
+#ifdef HAVE_INT128
+	*sum -= val;
+#else
+	*sum = finite_duration_mi(*sum, val);
+#endif
+}
+
+static inline void
+duration_sum_combine_internal(DurationSum *sum, DurationSum val)
+{
+#ifdef HAVE_INT128
+	*sum += val;
+#else
+	*sum = finite_duration_pl(*sum, val);
+#endif
+}
+
+/*
+ * Convert a sum of finite durations back to a finite Duration, or fail.
+ */
+static Duration
+duration_sum_result(DurationSum sum)
+{
+#ifdef HAVE_INT128
+	if (sum <= PG_INT64_MIN || sum >= PG_INT64_MAX)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
+#endif
+	return (Duration) sum;
+}
+
+/*
+ * Divide a sum of finite durations by a positive count, rounding half to
+ * even like interval avg() does.  The mean of finite durations is always a
+ * finite duration.
+ */
+static Duration
+duration_sum_mean(DurationSum sum, int64 count)
+{
+	DurationSum quotient = sum / count;
+	DurationSum remainder = sum % count;
+
+	Assert(count > 0);
+
+	if (remainder > 0 &&
+		(remainder > count - remainder ||
+		 (remainder == count - remainder && quotient % 2 != 0)))
+		quotient++;
+	else if (remainder < 0 &&
+			 (-remainder > count + remainder ||
+			  (-remainder == count + remainder && quotient % 2 != 0)))
+		quotient--;
+
+	return (Duration) quotient;
+}
+
+static void
+duration_square_sum_combine(DurationSquareSum *sum, const DurationSquareSum *val)
+{
+	uint64		carry;
+
+	sum->w[0] += val->w[0];
+	carry = sum->w[0] < val->w[0];
+	sum->w[1] += carry;
+	carry = sum->w[1] < carry;
+	sum->w[1] += val->w[1];
+	carry += sum->w[1] < val->w[1];
+	sum->w[2] += val->w[2] + carry;
+}
+
+/*
+ * Add or subtract the square of a finite duration to or from a running sum
+ * of squares.  The square is built from 32-bit halves of the magnitude,
+ * x^2 = a^2 * 2^64 + a * b * 2^33 + b^2, and then added with carries.
+ */
+static void
+duration_square_sum_accum(DurationSquareSum *sum, Duration val, bool subtract)
+{
+	uint64		magnitude = val < 0 ? -(uint64) val : (uint64) val;
+	uint64		a = magnitude >> 32;
+	uint64		b = magnitude & 0xFFFFFFFF;
+	uint64		ab = a * b;
+	DurationSquareSum square;
+
+	/* val is finite, so its square is below 2^126 and w[1] can't overflow */
+	square.w[0] = b * b + (ab << 33);
+	square.w[1] = a * a + (ab >> 31) + (square.w[0] < (ab << 33));
+	square.w[2] = 0;
+
+	if (!subtract)
+		duration_square_sum_combine(sum, &square);
+	else
+	{
+		uint64		borrow;
+
+		borrow = sum->w[0] < square.w[0];
+		sum->w[0] -= square.w[0];
+		sum->w[1] -= borrow;
+		borrow = sum->w[1] == PG_UINT64_MAX && borrow;
+		borrow += sum->w[1] < square.w[1];
+		sum->w[1] -= square.w[1];
+		sum->w[2] -= borrow;
+	}
+}
+
+/*
+ * Serialized sum() and avg() states are variable length, so that the common
+ * cases (a sum that fits in 64 bits, no infinite inputs) stay small.  The
+ * first byte says which parts follow.
+ */
+#define DA_SER_WIDE_SUM		0x01	/* sum is sent as 128 bits */
+#define DA_SER_PINF			0x02	/* +infinity count (or flag) follows */
+#define DA_SER_NINF			0x04	/* -infinity count (or flag) follows */
+#define DA_SER_SUMX2		0x08	/* sum of squares follows */
+
+static void
+duration_sum_send(StringInfo buf, DurationSum sum)
+{
+#ifdef HAVE_INT128
+	if (sum < PG_INT64_MIN || sum > PG_INT64_MAX)
+	{
+		pq_sendint64(buf, (int64) (sum >> 64));
+		pq_sendint64(buf, (int64) (uint64) sum);
+		return;
+	}
+#endif
+	pq_sendint64(buf, (int64) sum);
+}
+
+static DurationSum
+duration_sum_recv(StringInfo buf, uint8 flags)
+{
+	if (flags & DA_SER_WIDE_SUM)
+	{
+#ifdef HAVE_INT128
+		int64		hi = pq_getmsgint64(buf);
+		uint64		lo = (uint64) pq_getmsgint64(buf);
+
+		return (DurationSum) (((uint128) hi << 64) | lo);
+#else
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
+#endif
+	}
+	return pq_getmsgint64(buf);
+}
+
+static uint8
+duration_sum_flags(DurationSum sum)
+{
+#ifdef HAVE_INT128
+	if (sum < PG_INT64_MIN || sum > PG_INT64_MAX)
+		return DA_SER_WIDE_SUM;
+#endif
+	return 0;
+}
+
+/*
+ * Accumulate a new input value for duration aggregate functions.
+ */
+static void
+do_duration_accum(DurationAggState *state, Duration newval)
+{
+	/* Infinite inputs are counted separately, and do not affect "N" */
+	if (DURATION_IS_NOBEGIN(newval))
+	{
+		state->nInfcount++;
+		return;
+	}
+
+	if (DURATION_IS_NOEND(newval))
+	{
+		state->pInfcount++;
+		return;
+	}
+
+	duration_sum_add(&state->sumX, newval);
+	if (state->calcSumX2)
+		duration_square_sum_accum(&state->sumX2, newval, false);
+	state->N++;
+}
+
+/*
+ * Remove the given duration value from the aggregated state.
+ */
+static void
+do_duration_discard(DurationAggState *state, Duration newval)
+{
+	/* Infinite inputs are counted separately, and do not affect "N" */
+	if (DURATION_IS_NOBEGIN(newval))
+	{
+		state->nInfcount--;
+		return;
+	}
+
+	if (DURATION_IS_NOEND(newval))
+	{
+		state->pInfcount--;
+		return;
+	}
+
+	/* Handle the to-be-discarded finite value. */
+	state->N--;
+	if (state->N > 0)
+	{
+		duration_sum_sub(&state->sumX, newval);
+		if (state->calcSumX2)
+			duration_square_sum_accum(&state->sumX2, newval, true);
+	}
+	else
+	{
+		/* All values discarded, reset the state */
+		Assert(state->N == 0);
+		state->sumX = 0;
+		memset(&state->sumX2, 0, sizeof(state->sumX2));
+	}
+}
+
+/*
+ * Transition function for avg() and moving sum() duration aggregates.
+ */
+Datum
+duration_avg_accum(PG_FUNCTION_ARGS)
+{
+	DurationAggState *state;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
+
+	/* Create the state data on the first call */
+	if (state == NULL)
+		state = makeDurationAggState(fcinfo, false);
+
+	if (!PG_ARGISNULL(1))
+		do_duration_accum(state, PG_GETARG_DURATION(1));
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * Transition function for the variance and standard deviation duration
+ * aggregates, which also need the sum of squares.
+ */
+Datum
+duration_accum(PG_FUNCTION_ARGS)
+{
+	DurationAggState *state;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
+
+	/* Create the state data on the first call */
+	if (state == NULL)
+		state = makeDurationAggState(fcinfo, true);
+
+	if (!PG_ARGISNULL(1))
+		do_duration_accum(state, PG_GETARG_DURATION(1));
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * Combine function for avg(), variance and standard deviation duration
+ * aggregates.
+ *
+ * Combine the given internal aggregate states and place the combination in
+ * the first argument.
+ */
+Datum
+duration_avg_combine(PG_FUNCTION_ARGS)
+{
+	DurationAggState *state1;
+	DurationAggState *state2;
+
+	state1 = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
+	state2 = PG_ARGISNULL(1) ? NULL : (DurationAggState *) PG_GETARG_POINTER(1);
+
+	if (state2 == NULL)
+		PG_RETURN_POINTER(state1);
+
+	if (state1 == NULL)
+	{
+		/* manually copy all fields from state2 to state1 */
+		state1 = makeDurationAggState(fcinfo, state2->calcSumX2);
+
+		state1->N = state2->N;
+		state1->pInfcount = state2->pInfcount;
+		state1->nInfcount = state2->nInfcount;
+
+		state1->sumX = state2->sumX;
+		state1->sumX2 = state2->sumX2;
+
+		PG_RETURN_POINTER(state1);
+	}
+
+	state1->N += state2->N;
+	state1->pInfcount += state2->pInfcount;
+	state1->nInfcount += state2->nInfcount;
+
+	/* Accumulate finite duration values, if any. */
+	if (state2->N > 0)
+	{
+		duration_sum_combine_internal(&state1->sumX, state2->sumX);
+		if (state1->calcSumX2)
+			duration_square_sum_combine(&state1->sumX2, &state2->sumX2);
+	}
+
+	PG_RETURN_POINTER(state1);
+}
+
+/*
+ * duration_avg_serialize
+ *		Serialize DurationAggState for duration aggregates.
+ */
+Datum
+duration_avg_serialize(PG_FUNCTION_ARGS)
+{
+	DurationAggState *state;
+	StringInfoData buf;
+	bytea	   *result;
+	uint8		flags;
+
+	/* Ensure we disallow calling when not in aggregate context */
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = (DurationAggState *) PG_GETARG_POINTER(0);
+
+	flags = duration_sum_flags(state->sumX);
+	if (state->pInfcount != 0)
+		flags |= DA_SER_PINF;
+	if (state->nInfcount != 0)
+		flags |= DA_SER_NINF;
+	if (state->calcSumX2)
+		flags |= DA_SER_SUMX2;
+
+	pq_begintypsend(&buf);
+
+	pq_sendbyte(&buf, flags);
+
+	/* N */
+	pq_sendint64(&buf, state->N);
+
+	/* sumX */
+	duration_sum_send(&buf, state->sumX);
+
+	/* sumX2 */
+	if (flags & DA_SER_SUMX2)
+	{
+		for (int i = 0; i < lengthof(state->sumX2.w); i++)
+			pq_sendint64(&buf, (int64) state->sumX2.w[i]);
+	}
+
+	/* pInfcount */
+	if (flags & DA_SER_PINF)
+		pq_sendint64(&buf, state->pInfcount);
+
+	/* nInfcount */
+	if (flags & DA_SER_NINF)
+		pq_sendint64(&buf, state->nInfcount);
+
+	result = pq_endtypsend(&buf);
+
+	PG_RETURN_BYTEA_P(result);
+}
+
+/*
+ * duration_avg_deserialize
+ *		Deserialize bytea into DurationAggState for duration aggregates.
+ */
+Datum
+duration_avg_deserialize(PG_FUNCTION_ARGS)
+{
+	bytea	   *sstate;
+	DurationAggState *result;
+	StringInfoData buf;
+	uint8		flags;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	sstate = PG_GETARG_BYTEA_PP(0);
+
+	/*
+	 * Initialize a StringInfo so that we can "receive" it using the standard
+	 * recv-function infrastructure.
+	 */
+	initReadOnlyStringInfo(&buf, VARDATA_ANY(sstate),
+						   VARSIZE_ANY_EXHDR(sstate));
+
+	result = (DurationAggState *) palloc0(sizeof(DurationAggState));
+
+	flags = pq_getmsgbyte(&buf);
+
+	/* N */
+	result->N = pq_getmsgint64(&buf);
+
+	/* sumX */
+	result->sumX = duration_sum_recv(&buf, flags);
+
+	/* sumX2 */
+	if (flags & DA_SER_SUMX2)
+	{
+		result->calcSumX2 = true;
+		for (int i = 0; i < lengthof(result->sumX2.w); i++)
+			result->sumX2.w[i] = (uint64) pq_getmsgint64(&buf);
+	}
+
+	/* pInfcount */
+	if (flags & DA_SER_PINF)
+		result->pInfcount = pq_getmsgint64(&buf);
+
+	/* nInfcount */
+	if (flags & DA_SER_NINF)
+		result->nInfcount = pq_getmsgint64(&buf);
+
+	pq_getmsgend(&buf);
+
+	PG_RETURN_POINTER(result);
+}
+
+/*
+ * Inverse transition function for moving sum(), avg(), variance and standard
+ * deviation duration aggregates.
+ */
+Datum
+duration_avg_accum_inv(PG_FUNCTION_ARGS)
+{
+	DurationAggState *state;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
+
+	/* Should not get here with no state */
+	if (state == NULL)
+		elog(ERROR, "duration_avg_accum_inv called with NULL state");
+
+	if (!PG_ARGISNULL(1))
+		do_duration_discard(state, PG_GETARG_DURATION(1));
+
+	PG_RETURN_POINTER(state);
+}
+
+/* avg(duration) aggregate final function */
+Datum
+duration_avg(PG_FUNCTION_ARGS)
+{
+	DurationAggState *state;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
+
+	/* If there were no non-null inputs, return NULL */
+	if (state == NULL || DA_TOTAL_COUNT(state) == 0)
+		PG_RETURN_NULL();
+
+	/*
+	 * Aggregating infinities that all have the same sign produces infinity
+	 * with that sign.  Aggregating infinities with different signs results in
+	 * an error.
+	 */
+	if (state->pInfcount > 0 || state->nInfcount > 0)
+	{
+		Duration	result;
+
+		if (state->pInfcount > 0 && state->nInfcount > 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+					 errmsg("duration out of range")));
+
+		if (state->pInfcount > 0)
+			DURATION_NOEND(result);
+		else
+			DURATION_NOBEGIN(result);
+
+		PG_RETURN_DURATION(result);
+	}
+
+	PG_RETURN_DURATION(duration_sum_mean(state->sumX, state->N));
+}
+
+/* Moving sum(duration) aggregate final function */
+Datum
+duration_sum(PG_FUNCTION_ARGS)
+{
+	DurationAggState *state;
+	Duration	result;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
+
+	/* If there were no non-null inputs, return NULL */
+	if (state == NULL || DA_TOTAL_COUNT(state) == 0)
+		PG_RETURN_NULL();
+
+	/*
+	 * Aggregating infinities that all have the same sign produces infinity
+	 * with that sign.  Aggregating infinities with different signs results in
+	 * an error.
+	 */
+	if (state->pInfcount > 0 && state->nInfcount > 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
+
+	if (state->pInfcount > 0)
+		DURATION_NOEND(result);
+	else if (state->nInfcount > 0)
+		DURATION_NOBEGIN(result);
+	else
+		result = duration_sum_result(state->sumX);
+
+	PG_RETURN_DURATION(result);
+}
+
+/*
+ * Numeric 2^64, the base of the words of wide sums.
+ */
+static Numeric
+numeric_2_64(void)
+{
+	return DatumGetNumeric(DirectFunctionCall3(numeric_in,
+											   CStringGetDatum("18446744073709551616"),
+											   ObjectIdGetDatum(InvalidOid),
+											   Int32GetDatum(-1)));
+}
+
+static Numeric
+uint64_to_numeric(uint64 val)
+{
+	if (val <= PG_INT64_MAX)
+		return int64_to_numeric((int64) val);
+
+	/* val = 2 * (val >> 1) + (val & 1) */
+	return numeric_add_opt_error(numeric_mul_opt_error(int64_to_numeric((int64) (val >> 1)),
+													   int64_to_numeric(2), NULL),
+								 int64_to_numeric((int64) (val & 1)), NULL);
+}
+
+static Numeric
+duration_sum_to_numeric(DurationSum sum)
+{
+#ifdef HAVE_INT128
+	if (sum < PG_INT64_MIN || sum > PG_INT64_MAX)
+		return numeric_add_opt_error(numeric_mul_opt_error(int64_to_numeric((int64) (sum >> 64)),
+														   numeric_2_64(), NULL),
+									 uint64_to_numeric((uint64) sum), NULL);
+#endif
+	return int64_to_numeric((int64) sum);
+}
+
+static Numeric
+duration_square_sum_to_numeric(const DurationSquareSum *sum)
+{
+	Numeric		base = numeric_2_64();
+	Numeric		result = uint64_to_numeric(sum->w[2]);
+
+	for (int i = lengthof(sum->w) - 2; i >= 0; i--)
+		result = numeric_add_opt_error(numeric_mul_opt_error(result, base, NULL),
+									   uint64_to_numeric(sum->w[i]), NULL);
+	return result;
+}
+
+/*
+ * Common code for the variance and standard deviation aggregates.  Returns
+ * the variance in square microseconds, or NULL if it is undefined, which
+ * is when there are no inputs, or only one for a sample.  Any infinite input
+ * leaves the variance undefined too, which *is_inf reports, as infinite
+ * inputs make core's numeric and float8 variance NaN.
+ *
+ * Since the sums are exact, so is the numerator
+ *		N * sum(X^2) - sum(X)^2
+ * and the only rounding is in the final division, as in core's numeric
+ * variance.
+ */
+static Numeric
+duration_variance_internal(DurationAggState *state, bool sample, bool *is_inf)
+{
+	int64		totalCount;
+	Numeric		vN;
+	Numeric		numerator;
+	Numeric		denominator;
+
+	*is_inf = false;
+
+	if (state == NULL)
+		return NULL;
+
+	totalCount = DA_TOTAL_COUNT(state);
+	if (totalCount == 0 || (sample && totalCount == 1))
+		return NULL;
+
+	if (state->pInfcount > 0 || state->nInfcount > 0)
+	{
+		*is_inf = true;
+		return NULL;
+	}
+
+	vN = int64_to_numeric(state->N);
+	numerator = numeric_sub_opt_error(numeric_mul_opt_error(vN,
+															duration_square_sum_to_numeric(&state->sumX2),
+															NULL),
+									  numeric_mul_opt_error(duration_sum_to_numeric(state->sumX),
+															duration_sum_to_numeric(state->sumX),
+															NULL),
+									  NULL);
+	denominator = numeric_mul_opt_error(vN,
+										sample ? int64_to_numeric(state->N - 1) : vN,
+										NULL);
+
+	return DatumGetNumeric(DirectFunctionCall2(numeric_div,
+											   NumericGetDatum(numerator),
+											   NumericGetDatum(denominator)));
+}
+
+/*
+ * The variance aggregates return numeric square seconds, or NaN if there are
+ * infinite inputs.
+ */
+static Datum
+duration_variance_final(FunctionCallInfo fcinfo, bool sample)
+{
+	DurationAggState *state;
+	Numeric		variance;
+	bool		is_inf;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
+
+	variance = duration_variance_internal(state, sample, &is_inf);
+
+	if (is_inf)
+		return DirectFunctionCall3(numeric_in,
+								   CStringGetDatum("NaN"),
+								   ObjectIdGetDatum(InvalidOid),
+								   Int32GetDatum(-1));
+	if (variance == NULL)
+		PG_RETURN_NULL();
+
+	/*
+	 * Convert square microseconds to square seconds, without the trailing
+	 * zeroes that the division would leave.
+	 */
+	return DirectFunctionCall1(numeric_trim_scale,
+							   DirectFunctionCall2(numeric_div,
+												   NumericGetDatum(variance),
+												   NumericGetDatum(int64_to_numeric(INT64CONST(1000000000000)))));
+}
+
+/*
+ * The standard deviation aggregates return a duration, rounded to the
+ * nearest microsecond.  A duration has no NaN, so infinite inputs are an
+ * error, as mixed infinities are for sum().
+ */
+static Datum
+duration_stddev_final(FunctionCallInfo fcinfo, bool sample)
+{
+	DurationAggState *state;
+	Numeric		variance;
+	bool		is_inf;
+	Datum		stddev;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
+
+	variance = duration_variance_internal(state, sample, &is_inf);
+
+	if (is_inf)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
+	if (variance == NULL)
+		PG_RETURN_NULL();
+
+	stddev = DirectFunctionCall1(numeric_sqrt, NumericGetDatum(variance));
+	stddev = DirectFunctionCall2(numeric_round, stddev, Int32GetDatum(0));
+
+	/* Durations far apart can have a spread that is not a duration itself */
+	if (DatumGetInt32(DirectFunctionCall2(numeric_cmp, stddev,
+										  NumericGetDatum(int64_to_numeric(PG_INT64_MAX)))) >= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
+
+	PG_RETURN_DURATION(DatumGetInt64(DirectFunctionCall1(numeric_int8, stddev)));
+}
+
+/* var_pop(duration) aggregate final function */
+Datum
+duration_var_pop(PG_FUNCTION_ARGS)
+{
+	return duration_variance_final(fcinfo, false);
+}
+
+/* var_samp(duration) aggregate final function */
+Datum
+duration_var_samp(PG_FUNCTION_ARGS)
+{
+	return duration_variance_final(fcinfo, true);
+}
+
+/* stddev_pop(duration) aggregate final function */
+Datum
+duration_stddev_pop(PG_FUNCTION_ARGS)
+{
+	return duration_stddev_final(fcinfo, false);
+}
+
+/* stddev_samp(duration) aggregate final function */
+Datum
+duration_stddev_samp(PG_FUNCTION_ARGS)
+{
+	return duration_stddev_final(fcinfo, true);
+}
+
+/*
+ * Transition function for the (non-moving) sum() duration aggregate.  A NULL
+ * state means there were no non-null inputs, so unlike DurationAggState no
+ * counts are needed.
+ */
+Datum
+duration_sum_accum(PG_FUNCTION_ARGS)
+{
+	DurationSumState *state;
+	Duration	newval;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationSumState *) PG_GETARG_POINTER(0);
+
+	if (PG_ARGISNULL(1))
+		PG_RETURN_POINTER(state);
+
+	/* Create the state data on the first non-null input */
+	if (state == NULL)
+		state = makeDurationSumState(fcinfo);
+
+	newval = PG_GETARG_DURATION(1);
+	if (DURATION_IS_NOBEGIN(newval))
+		state->nInf = true;
+	else if (DURATION_IS_NOEND(newval))
+		state->pInf = true;
+	else
+		duration_sum_add(&state->sumX, newval);
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * Combine function for the sum() duration aggregate.
+ */
+Datum
+duration_sum_combine(PG_FUNCTION_ARGS)
+{
+	DurationSumState *state1;
+	DurationSumState *state2;
+
+	state1 = PG_ARGISNULL(0) ? NULL : (DurationSumState *) PG_GETARG_POINTER(0);
+	state2 = PG_ARGISNULL(1) ? NULL : (DurationSumState *) PG_GETARG_POINTER(1);
+
+	if (state2 == NULL)
+		PG_RETURN_POINTER(state1);
+
+	if (state1 == NULL)
+	{
+		state1 = makeDurationSumState(fcinfo);
+		*state1 = *state2;
+		PG_RETURN_POINTER(state1);
+	}
+
+	state1->pInf |= state2->pInf;
+	state1->nInf |= state2->nInf;
+	duration_sum_combine_internal(&state1->sumX, state2->sumX);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/*
+ * duration_sum_serialize
+ *		Serialize DurationSumState for the sum() duration aggregate.
+ */
+Datum
+duration_sum_serialize(PG_FUNCTION_ARGS)
+{
+	DurationSumState *state;
+	StringInfoData buf;
+	uint8		flags;
+
+	/* Ensure we disallow calling when not in aggregate context */
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = (DurationSumState *) PG_GETARG_POINTER(0);
+
+	flags = duration_sum_flags(state->sumX);
+	if (state->pInf)
+		flags |= DA_SER_PINF;
+	if (state->nInf)
+		flags |= DA_SER_NINF;
+
+	pq_begintypsend(&buf);
+	pq_sendbyte(&buf, flags);
+	duration_sum_send(&buf, state->sumX);
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/*
+ * duration_sum_deserialize
+ *		Deserialize bytea into DurationSumState for the sum() duration
+ *		aggregate.
+ */
+Datum
+duration_sum_deserialize(PG_FUNCTION_ARGS)
+{
+	bytea	   *sstate;
+	DurationSumState *result;
+	StringInfoData buf;
+	uint8		flags;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	sstate = PG_GETARG_BYTEA_PP(0);
+
+	initReadOnlyStringInfo(&buf, VARDATA_ANY(sstate),
+						   VARSIZE_ANY_EXHDR(sstate));
+
+	result = (DurationSumState *) palloc0(sizeof(DurationSumState));
+
+	flags = pq_getmsgbyte(&buf);
+	result->sumX = duration_sum_recv(&buf, flags);
+	result->pInf = (flags & DA_SER_PINF) != 0;
+	result->nInf = (flags & DA_SER_NINF) != 0;
+
+	pq_getmsgend(&buf);
+
+	PG_RETURN_POINTER(result);
+}
+
+/* sum(duration) aggregate final function */
+Datum
+duration_sum_final(PG_FUNCTION_ARGS)
+{
+	DurationSumState *state;
+	Duration	result;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationSumState *) PG_GETARG_POINTER(0);
+
+	/* If there were no non-null inputs, return NULL */
+	if (state == NULL)
+		PG_RETURN_NULL();
+
+	/*
+	 * Aggregating infinities that all have the same sign produces infinity
+	 * with that sign.  Aggregating infinities with different signs results in
+	 * an error.
+	 */
+	if (state->pInf && state->nInf)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
+
+	if (state->pInf)
+		DURATION_NOEND(result);
+	else if (state->nInf)
+		DURATION_NOBEGIN(result);
+	else
+		result = duration_sum_result(state->sumX);
+
+	PG_RETURN_DURATION(result);
+}
+
+Datum
+duration_smaller(PG_FUNCTION_ARGS)
+{
+	Duration	a = PG_GETARG_DURATION(0);
+	Duration	b = PG_GETARG_DURATION(1);
+	int			cmp;
+	Duration	result;
+
+	cmp = DatumGetInt32(DirectFunctionCall2(duration_cmp, a, b));
+	result = cmp < 0 ? a : b;
+
+	PG_RETURN_DURATION(result);
+}
+
+Datum
+duration_larger(PG_FUNCTION_ARGS)
+{
+	Duration	a = PG_GETARG_DURATION(0);
+	Duration	b = PG_GETARG_DURATION(1);
+	int			cmp;
+	Duration	result;
+
+	cmp = DatumGetInt32(DirectFunctionCall2(duration_cmp, a, b));
+	result = cmp > 0 ? a : b;
+
+	PG_RETURN_DURATION(result);
+}
+
+/*
+ * Moving-aggregate state of min() and max(): a monotonic deque of the values
+ * in the window frame that may still become its extreme, i.e. those with no
+ * later value at least as extreme.  The front is the extreme of the frame.
+ *
+ * Values leave a moving frame in the order they entered it, so each is tagged
+ * with its position in the input; when the row at the front's position
+ * leaves, the front goes with it, and otherwise the leaving value was already
+ * dropped from the back.  Every value is pushed and popped at most once, so
+ * the cost per row is amortized O(1) however wide the frame is.
+ *
+ * The deque is a ring buffer, with a power-of-2 capacity.
+ */
+typedef struct DurationMinMaxEntry
+{
+	Duration	value;
+	int64		pos;			/* position of the value in the input */
+} DurationMinMaxEntry;
+
+typedef struct DurationMinMaxState
+{
+	DurationMinMaxEntry *entries;
+	int64		capacity;		/* allocated length of entries */
+	int64		head;			/* index of the front entry */
+	int64		count;			/* number of entries in the deque */
+	int64		nadded;			/* non-null values added so far */
+	int64		nremoved;		/* non-null values removed so far */
+} DurationMinMaxState;
+
+#define DURATION_MINMAX_INITIAL_CAPACITY	16
+
+#define DURATION_MINMAX_ENTRY(state, i) \
+	((state)->entries[((state)->head + (i)) & ((state)->capacity - 1)])
+
+static DurationMinMaxState *
+makeDurationMinMaxState(FunctionCallInfo fcinfo)
+{
+	DurationMinMaxState *state;
+	MemoryContext agg_context;
+	MemoryContext old_context;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	DURATION_STATS_INC(DURATION_STATS_AGG_STATE);
+
+	old_context = MemoryContextSwitchTo(agg_context);
+
+	state = (DurationMinMaxState *) palloc0(sizeof(DurationMinMaxState));
+	state->capacity = DURATION_MINMAX_INITIAL_CAPACITY;
+	state->entries = (DurationMinMaxEntry *)
+		palloc(state->capacity * sizeof(DurationMinMaxEntry));
+
+	MemoryContextSwitchTo(old_context);
+
+	return state;
+}
+
+/*
+ * Add a value at the back of the deque, first dropping the values it makes
+ * redundant: those no more extreme than it, which will leave the frame before
+ * it does.
+ */
+static void
+duration_minmax_push(DurationMinMaxState *state, Duration newval, bool is_min)
+{
+	DurationMinMaxEntry *entry;
+
+	while (state->count > 0)
+	{
+		Duration	back = DURATION_MINMAX_ENTRY(state, state->count - 1).value;
+
+		if (is_min ? back < newval : back > newval)
+			break;
+		state->count--;
+	}
+
+	if (state->count == state->capacity)
+	{
+		int64		old_capacity = state->capacity;
+
+		/* repalloc keeps the buffer in the aggregate context */
+		state->capacity *= 2;
+		state->entries = (DurationMinMaxEntry *)
+			repalloc_huge(state->entries,
+						  state->capacity * sizeof(DurationMinMaxEntry));
+
+		/* Move the wrapped-around part past the old end */
+		if (state->head > 0)
+			memcpy(state->entries + old_capacity, state->entries,
+				   state->head * sizeof(DurationMinMaxEntry));
+	}
+
+	entry = &DURATION_MINMAX_ENTRY(state, state->count);
+	entry->value = newval;
+	entry->pos = state->nadded++;
+	state->count++;
+}
+
+/*
+ * Moving-aggregate transition function for min(duration).
+ */
+Datum
+duration_smaller_accum(PG_FUNCTION_ARGS)
+{
+	DurationMinMaxState *state;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationMinMaxState *) PG_GETARG_POINTER(0);
+
+	/* Create the state data on the first call */
+	if (state == NULL)
+		state = makeDurationMinMaxState(fcinfo);
+
+	if (!PG_ARGISNULL(1))
+		duration_minmax_push(state, PG_GETARG_DURATION(1), true);
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * Moving-aggregate transition function for max(duration).
+ */
+Datum
+duration_larger_accum(PG_FUNCTION_ARGS)
+{
+	DurationMinMaxState *state;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationMinMaxState *) PG_GETARG_POINTER(0);
+
+	/* Create the state data on the first call */
+	if (state == NULL)
+		state = makeDurationMinMaxState(fcinfo);
+
+	if (!PG_ARGISNULL(1))
+		duration_minmax_push(state, PG_GETARG_DURATION(1), false);
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * Inverse transition function for moving min() and max() duration aggregates.
+ */
+Datum
+duration_minmax_accum_inv(PG_FUNCTION_ARGS)
+{
+	DurationMinMaxState *state;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationMinMaxState *) PG_GETARG_POINTER(0);
+
+	/* Should not get here with no state */
+	if (state == NULL)
+		elog(ERROR, "duration_minmax_accum_inv called with NULL state");
+
+	if (!PG_ARGISNULL(1))
+	{
+		if (state->count > 0 &&
+			DURATION_MINMAX_ENTRY(state, 0).pos == state->nremoved)
+		{
+			Assert(DURATION_MINMAX_ENTRY(state, 0).value == PG_GETARG_DURATION(1));
+			state->head = (state->head + 1) & (state->capacity - 1);
+			state->count--;
+		}
+		state->nremoved++;
+	}
+
+	PG_RETURN_POINTER(state);
+}
+
+/* Moving min(duration) and max(duration) aggregate final function */
+Datum
+duration_minmax_final(PG_FUNCTION_ARGS)
+{
+	DurationMinMaxState *state;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationMinMaxState *) PG_GETARG_POINTER(0);
+
+	/* If there are no non-null inputs in the frame, return NULL */
+	if (state == NULL || state->count == 0)
+		PG_RETURN_NULL();
+
+	PG_RETURN_DURATION(DURATION_MINMAX_ENTRY(state, 0).value);
+}
+
+/*****************************************************************************
+ *				   Ordered-set aggregates
+ *****************************************************************************/
+
+/*
+ * Transition state for percentile_cont(), percentile_disc() and median().
+ *
+ * Inputs are collected as raw int64s, which costs a fraction of what a
+ * tuplesort does per value and lets us select or radix sort them directly.
+ * If more than work_mem worth of values arrive, the buffer is handed over to
+ * a tuplesort, which can spill to disk.
+ */
+typedef struct DurationPercentileState
+{
+	Duration   *values;			/* in-memory values, unused once spilled */
+	int64		nvalues;		/* number of non-null inputs */
+	int64		maxvalues;		/* allocated length of values */
+	int64		memvalues;		/* most values kept in memory */
+	Tuplesortstate *sortstate;	/* non-NULL once spilled */
+	bool		sorted;			/* values or sortstate is sorted */
+} DurationPercentileState;
+
+/* Below this many values, a comparison sort beats a radix sort */
+#define DURATION_RADIX_SORT_THRESHOLD	256
+
+static int
+duration_qsort_cmp(const void *a, const void *b)
+{
+	Duration	da = *(const Duration *) a;
+	Duration	db = *(const Duration *) b;
+
+	if (da < db)
+		return -1;
+	else if (da > db)
+		return 1;
+	else
+		return 0;
+}
+
+/*
+ * LSD radix sort of durations, one byte per pass.  Flipping the sign bit makes
+ * the unsigned byte order match signed order.  Passes where every value has
+ * the same byte, as the high bytes usually do, are skipped.
+ */
+static void
+duration_radix_sort(Duration *values, int64 nvalues)
+{
+	uint64	   *src = (uint64 *) values;
+	uint64	   *dst;
+	uint64		signbit = UINT64CONST(1) << 63;
+
+	if (nvalues < DURATION_RADIX_SORT_THRESHOLD)
+	{
+		qsort(values, nvalues, sizeof(Duration), duration_qsort_cmp);
+		return;
+	}
+
+	dst = (uint64 *) palloc_extended(nvalues * sizeof(uint64), MCXT_ALLOC_HUGE);
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		int64		counts[256] = {0};
+		int64		offset = 0;
+		uint64	   *tmp;
+
+		for (int64 i = 0; i < nvalues; i++)
+			counts[((src[i] ^ signbit) >> shift) & 0xFF]++;
+
+		if (counts[((src[0] ^ signbit) >> shift) & 0xFF] == nvalues)
+			continue;
+
+		for (int b = 0; b < 256; b++)
+		{
+			int64		count = counts[b];
+
+			counts[b] = offset;
+			offset += count;
+		}
+
+		for (int64 i = 0; i < nvalues; i++)
+			dst[counts[((src[i] ^ signbit) >> shift) & 0xFF]++] = src[i];
+
+		tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	if (src != (uint64 *) values)
+	{
+		memcpy(values, src, nvalues * sizeof(Duration));
+		pfree(src);
+	}
+	else
+		pfree(dst);
+}
+
+/*
+ * Return the value that would be at 0-based position k if values were sorted,
+ * partially reordering values in place (quickselect).  Falls back to sorting
+ * the remaining range if the partitioning isn't converging.
+ */
+static Duration
+duration_select(Duration *values, int64 nvalues, int64 k)
+{
+	int64		lo = 0;
+	int64		hi = nvalues - 1;
+	int			iterations = 0;
+
+	Assert(k >= 0 && k < nvalues);
+
+	while (lo < hi)
+	{
+		int64		mid = lo + (hi - lo) / 2;
+		Duration	pivot;
+		int64		i;
+		int64		j;
+
+		if (++iterations > 64)
+		{
+			duration_radix_sort(values + lo, hi - lo + 1);
+			break;
+		}
+
+		/* median of three */
+		if (values[mid] < values[lo])
+			SWAP_DURATION(values[mid], values[lo]);
+		if (values[hi] < values[lo])
+			SWAP_DURATION(values[hi], values[lo]);
+		if (values[hi] < values[mid])
+			SWAP_DURATION(values[hi], values[mid]);
+		pivot = values[mid];
+
+		i = lo;
+		j = hi;
+		while (i <= j)
+		{
+			while (values[i] < pivot)
+				i++;
+			while (values[j] > pivot)
+				j--;
+			if (i <= j)
+			{
+				SWAP_DURATION(values[i], values[j]);
+				i++;
+				j--;
+			}
+		}
+
+		if (k <= j)
+			hi = j;
+		else if (k >= i)
+			lo = i;
+		else
+			break;
+	}
+
+	return values[k];
+}
+
+static void
+duration_percentile_shutdown(Datum arg)
+{
+	DurationPercentileState *state = (DurationPercentileState *) DatumGetPointer(arg);
+
+	/* Tuplesort object might have temp files. */
+	if (state->sortstate)
+		tuplesort_end(state->sortstate);
+	state->sortstate = NULL;
+}
+
+/*
+ * Move the in-memory values into a tuplesort.  Durations sort exactly like
+ * int8, so we can use its ordering operator.
+ */
+static void
+duration_percentile_spill(DurationPercentileState *state)
+{
+	state->sortstate = tuplesort_begin_datum(INT8OID, Int8LessOperator,
+											 InvalidOid, false, work_mem,
+											 NULL, TUPLESORT_NONE);
+	for (int64 i = 0; i < state->nvalues; i++)
+		tuplesort_putdatum(state->sortstate, DurationGetDatum(state->values[i]),
+						   false);
+
+	pfree(state->values);
+	state->values = NULL;
+	state->maxvalues = 0;
+}
+
+/*
+ * Transition function for the duration percentile aggregates.
+ */
+Datum
+duration_percentile_accum(PG_FUNCTION_ARGS)
+{
+	DurationPercentileState *state;
+	MemoryContext agg_context;
+	MemoryContext old_context;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationPercentileState *) PG_GETARG_POINTER(0);
+
+	/* Everything, including the tuplesort, lives in the aggregate context */
+	old_context = MemoryContextSwitchTo(agg_context);
+
+	/* Create the state data on the first call */
+	if (state == NULL)
+	{
+		state = (DurationPercentileState *) palloc0(sizeof(DurationPercentileState));
+		state->memvalues = Max((int64) work_mem * 1024 / (int64) sizeof(Duration),
+							   DURATION_RADIX_SORT_THRESHOLD);
+		AggRegisterCallback(fcinfo, duration_percentile_shutdown,
+							PointerGetDatum(state));
+	}
+
+	if (!PG_ARGISNULL(1))
+	{
+		Duration	duration = PG_GETARG_DURATION(1);
+
+		if (state->sortstate == NULL && state->nvalues >= state->maxvalues)
+		{
+			if (state->maxvalues >= state->memvalues)
+				duration_percentile_spill(state);
+			else if (state->values == NULL)
+			{
+				state->maxvalues = Min(64, state->memvalues);
+				state->values = (Duration *)
+					palloc(state->maxvalues * sizeof(Duration));
+			}
+			else
+			{
+				state->maxvalues = Min(state->maxvalues * 2, state->memvalues);
+				state->values = (Duration *)
+					repalloc_huge(state->values,
+								  state->maxvalues * sizeof(Duration));
+			}
+		}
+
+		if (state->sortstate)
+			tuplesort_putdatum(state->sortstate, DurationGetDatum(duration), false);
+		else
+			state->values[state->nvalues] = duration;
+		state->nvalues++;
+	}
+
+	MemoryContextSwitchTo(old_context);
+
+	PG_RETURN_POINTER(state);
+}
+
+static int
+int64_qsort_cmp(const void *a, const void *b)
+{
+	int64		ia = **(int64 *const *) a;
+	int64		ib = **(int64 *const *) b;
+
+	if (ia < ib)
+		return -1;
+	else if (ia > ib)
+		return 1;
+	else
+		return 0;
+}
+
+/*
+ * Set out[i] to the value at 0-based position rows[i] of the sorted inputs.
+ * This may only be called once per group.
+ */
+static void
+duration_percentile_fetch(DurationPercentileState *state, int64 *rows,
+						  Duration *out, int nrows)
+{
+	if (state->sortstate == NULL)
+	{
+		/* A couple of selections are cheaper than a full sort */
+		if (nrows <= 2 && !state->sorted)
+		{
+			for (int i = 0; i < nrows; i++)
+				out[i] = duration_select(state->values, state->nvalues, rows[i]);
+		}
+		else
+		{
+			if (!state->sorted)
+				duration_radix_sort(state->values, state->nvalues);
+			state->sorted = true;
+			for (int i = 0; i < nrows; i++)
+				out[i] = state->values[rows[i]];
+		}
+	}
+	else
+	{
+		int64	  **order;
+		int64		pos = 0;
+		Duration	last = 0;
+
+		if (state->sorted)
+			elog(ERROR, "duration percentile state was already read");
+		tuplesort_performsort(state->sortstate);
+		state->sorted = true;
+
+		/* Read the requested rows in ascending order */
+		order = (int64 **) palloc(nrows * sizeof(int64 *));
+		for (int i = 0; i < nrows; i++)
+			order[i] = &rows[i];
+		qsort(order, nrows, sizeof(int64 *), int64_qsort_cmp);
+
+		for (int i = 0; i < nrows; i++)
+		{
+			int64		row = *order[i];
+
+			if (row >= pos)
+			{
+				Datum		datum;
+				bool		isnull;
+
+				if (row > pos &&
+					!tuplesort_skiptuples(state->sortstate, row - pos, true))
+					elog(ERROR, "missing row in duration percentile");
+				if (!tuplesort_getdatum(state->sortstate, true, false,
+										&datum, &isnull, NULL))
+					elog(ERROR, "missing row in duration percentile");
+				last = DatumGetDuration(datum);
+				pos = row + 1;
+			}
+			out[order[i] - rows] = last;
+		}
+
+		pfree(order);
+	}
+}
+
+static void
+duration_percentile_check(float8 percentile)
+{
+	if (percentile < 0 || percentile > 1 || isnan(percentile))
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("percentile value %g is not between 0 and 1",
+						percentile)));
+}
+
+/* 0-based row of the percentile_disc() result */
+static int64
+duration_percentile_disc_row(float8 percentile, int64 rowcount)
+{
+	int64		rownum = (int64) ceil(percentile * rowcount);
+
+	return rownum > 0 ? rownum - 1 : 0;
+}
+
+/*
+ * Interpolate between the two rows around a percentile_cont() result.
+ *
+ * Infinities are handled the way interval's percentile_cont() handles them:
+ * it computes lo + (hi - lo) * proportion in interval arithmetic, where
+ * subtracting an infinity from itself, or adding infinities of opposite
+ * signs, is an error.  So any infinite lo is an error, and a finite lo with
+ * an infinite hi gives hi.
+ */
+static Duration
+duration_lerp(Duration lo, Duration hi, float8 proportion)
+{
+	uint64		diff;
+	float8		offset;
+
+	/* Exactly on a row, where interval doesn't interpolate either */
+	if (proportion == 0.0)
+		return lo;
+
+	if (DURATION_NOT_FINITE(lo))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
+	if (DURATION_IS_NOEND(hi))
+		return hi;
+
+	/*
+	 * hi - lo may not fit in an int64, but it always fits in a uint64, and
+	 * only the scaled offset needs rounding.  The result lies between lo and
+	 * hi, so adding the offset can't overflow.
+	 */
+	diff = (uint64) hi - (uint64) lo;
+	offset = rint((float8) diff * proportion);
+	if (offset >= (float8) diff)
+		return hi;
+
+	return (Duration) ((uint64) lo + (uint64) offset);
+}
+
+static Duration
+duration_percentile_cont_internal(DurationPercentileState *state,
+								  float8 percentile)
+{
+	float8		position = percentile * (state->nvalues - 1);
+	int64		rows[2];
+	Duration	values[2];
+
+	rows[0] = (int64) floor(position);
+	rows[1] = (int64) ceil(position);
+	duration_percentile_fetch(state, rows, values, rows[0] == rows[1] ? 1 : 2);
+	if (rows[0] == rows[1])
+		return values[0];
+
+	return duration_lerp(values[0], values[1], position - rows[0]);
+}
+
+/*
+ * percentile_disc(float8) within group (duration) - discrete percentile
+ */
+Datum
+duration_percentile_disc_final(PG_FUNCTION_ARGS)
+{
+	DurationPercentileState *state;
+	float8		percentile;
+	int64		row;
+	Duration	result;
+
+	/* Get and check the percentile argument */
+	if (PG_ARGISNULL(1))
+		PG_RETURN_NULL();
+
+	percentile = PG_GETARG_FLOAT8(1);
+	duration_percentile_check(percentile);
+
+	/* If there were no regular rows, the result is NULL */
+	state = PG_ARGISNULL(0) ? NULL : (DurationPercentileState *) PG_GETARG_POINTER(0);
+	if (state == NULL || state->nvalues == 0)
+		PG_RETURN_NULL();
+
+	row = duration_percentile_disc_row(percentile, state->nvalues);
+	duration_percentile_fetch(state, &row, &result, 1);
+
+	PG_RETURN_DURATION(result);
+}
+
+/*
+ * percentile_cont(float8) within group (duration) - continuous percentile
+ */
+Datum
+duration_percentile_cont_final(PG_FUNCTION_ARGS)
+{
+	DurationPercentileState *state;
+	float8		percentile;
+
+	/* Get and check the percentile argument */
+	if (PG_ARGISNULL(1))
+		PG_RETURN_NULL();
+
+	percentile = PG_GETARG_FLOAT8(1);
+	duration_percentile_check(percentile);
+
+	/* If there were no regular rows, the result is NULL */
+	state = PG_ARGISNULL(0) ? NULL : (DurationPercentileState *) PG_GETARG_POINTER(0);
+	if (state == NULL || state->nvalues == 0)
+		PG_RETURN_NULL();
+
+	PG_RETURN_DURATION(duration_percentile_cont_internal(state, percentile));
+}
+
+/*
+ * Common code for the array forms of percentile_disc and percentile_cont.
+ * The result has the same dimensions as the percentile array, with NULL
+ * wherever a percentile is NULL.
+ */
+static Datum
+duration_percentile_multi_final(FunctionCallInfo fcinfo, bool continuous)
+{
+	DurationPercentileState *state;
+	ArrayType  *param;
+	Datum	   *percentiles_datum;
+	bool	   *percentiles_null;
+	int			num_percentiles;
+	int64	   *rows;
+	Duration   *values;
+	Datum	   *result_datum;
+	int			nrows = 0;
+	Oid			elemtype;
+
+	/* If there were no regular rows, the result is NULL */
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+	state = (DurationPercentileState *) PG_GETARG_POINTER(0);
+	if (state == NULL || state->nvalues == 0)
+		PG_RETURN_NULL();
+
+	/* Deconstruct the percentile-array input */
+	if (PG_ARGISNULL(1))
+		PG_RETURN_NULL();
+	param = PG_GETARG_ARRAYTYPE_P(1);
+
+	deconstruct_array_builtin(param, FLOAT8OID,
+							  &percentiles_datum,
+							  &percentiles_null,
+							  &num_percentiles);
+
+	elemtype = get_element_type(get_fn_expr_rettype(fcinfo->flinfo));
+	if (!OidIsValid(elemtype))
+		elog(ERROR, "could not determine duration array type");
+
+	if (num_percentiles == 0)
+		PG_RETURN_POINTER(construct_empty_array(elemtype));
+
+	/* Work out every row we need, then fetch them all in one pass */
+	rows = (int64 *) palloc(2 * num_percentiles * sizeof(int64));
+	values = (Duration *) palloc(2 * num_percentiles * sizeof(Duration));
+	for (int i = 0; i < num_percentiles; i++)
+	{
+		float8		percentile;
+
+		if (percentiles_null[i])
+			continue;
+
+		percentile = DatumGetFloat8(percentiles_datum[i]);
+		duration_percentile_check(percentile);
+
+		if (continuous)
+		{
+			float8		position = percentile * (state->nvalues - 1);
+
+			rows[nrows++] = (int64) floor(position);
+			rows[nrows++] = (int64) ceil(position);
+		}
+		else
+			rows[nrows++] = duration_percentile_disc_row(percentile,
+														 state->nvalues);
+	}
+
+	duration_percentile_fetch(state, rows, values, nrows);
+
+	result_datum = (Datum *) palloc(num_percentiles * sizeof(Datum));
+	nrows = 0;
+	for (int i = 0; i < num_percentiles; i++)
+	{
+		if (percentiles_null[i])
+		{
+			result_datum[i] = (Datum) 0;
+			continue;
+		}
+
+		if (continuous)
+		{
+			float8		position = DatumGetFloat8(percentiles_datum[i]) *
+				(state->nvalues - 1);
+
+			result_datum[i] =
+				DurationGetDatum(duration_lerp(values[nrows], values[nrows + 1],
+											   position - rows[nrows]));
+			nrows += 2;
+		}
+		else
+			result_datum[i] = DurationGetDatum(values[nrows++]);
+	}
+
+	PG_RETURN_POINTER(construct_md_array(result_datum,
+										 percentiles_null,
+										 ARR_NDIM(param),
+										 ARR_DIMS(param),
+										 ARR_LBOUND(param),
+										 elemtype,
+										 sizeof(Duration),
+										 FLOAT8PASSBYVAL,
+										 TYPALIGN_DOUBLE));
+}
+
+/*
+ * percentile_disc(float8[]) within group (duration) - discrete percentiles
+ */
+Datum
+duration_percentile_disc_multi_final(PG_FUNCTION_ARGS)
+{
+	return duration_percentile_multi_final(fcinfo, false);
+}
+
+/*
+ * percentile_cont(float8[]) within group (duration) - continuous percentiles
+ */
+Datum
+duration_percentile_cont_multi_final(PG_FUNCTION_ARGS)
+{
+	return duration_percentile_multi_final(fcinfo, true);
+}
+
+/* median(duration) aggregate final function */
+Datum
+duration_median_final(PG_FUNCTION_ARGS)
+{
+	DurationPercentileState *state;
+
+	/* If there were no regular rows, the result is NULL */
+	state = PG_ARGISNULL(0) ? NULL : (DurationPercentileState *) PG_GETARG_POINTER(0);
+	if (state == NULL || state->nvalues == 0)
+		PG_RETURN_NULL();
+
+	PG_RETURN_DURATION(duration_percentile_cont_internal(state, 0.5));
+}
+
+/*****************************************************************************
+ *				   Quantile sketches
+ *****************************************************************************/
+
+/*
+ * A duration_sketch is a DDSketch: every finite nonzero duration is counted
+ * in a logarithmic bin of its magnitude, so any quantile read back from it
+ * is within a relative error of alpha of a true input value.  Sketches built
+ * with the same alpha merge exactly by adding bin counts, which is what
+ * makes them usable in parallel aggregation and for rolling up stored
+ * sketches.
+ *
+ * Bin k of the positive (or negative) store counts durations whose magnitude
+ * in microseconds lies in (gamma^(k-1), gamma^k], with
+ * gamma = (1 + alpha) / (1 - alpha).  Zero and the two infinities are
+ * counted separately.
+ */
+typedef struct DurationSketchBin
+{
+	int32		index;			/* bin number */
+	int64		count;			/* number of durations in the bin, > 0 */
+} DurationSketchBin;
+
+typedef struct DurationSketch
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	int32		nneg;			/* number of negative bins */
+	int32		npos;			/* number of positive bins */
+	float8		alpha;			/* relative accuracy */
+	int64		zero_count;		/* number of zero durations */
+	int64		ninf_count;		/* number of -infinity durations */
+	int64		pinf_count;		/* number of +infinity durations */
+	Duration	min;			/* smallest finite duration, if any */
+	Duration	max;			/* largest finite duration, if any */
+	/* nneg negative bins, then npos positive bins, each by ascending index */
+	DurationSketchBin bins[FLEXIBLE_ARRAY_MEMBER];
+} DurationSketch;
+
+#define DatumGetDurationSketchP(X)	((DurationSketch *) PG_DETOAST_DATUM(X))
+#define PG_GETARG_DURATION_SKETCH_P(n)	DatumGetDurationSketchP(PG_GETARG_DATUM(n))
+#define PG_RETURN_DURATION_SKETCH_P(x)	PG_RETURN_POINTER(x)
+
+#define DURATION_SKETCH_DEFAULT_ALPHA	0.01
+#define DURATION_SKETCH_MIN_ALPHA		0.001
+#define DURATION_SKETCH_MAX_ALPHA		0.5
+
+/*
+ * The transition state of duration_sketch_agg() and sketch_merge(), with
+ * the bins kept dense so that adding a value is a single increment.  The
+ * bin arrays are only allocated once a value of that sign turns up.
+ */
+typedef struct DurationSketchState
+{
+	float8		alpha;			/* relative accuracy */
+	float8		log_gamma;		/* ln(gamma) */
+	int32		nbins;			/* length of neg and pos */
+	int64	   *neg;			/* counts of negative durations by bin */
+	int64	   *pos;			/* counts of positive durations by bin */
+	int64		zero_count;		/* number of zero durations */
+	int64		ninf_count;		/* number of -infinity durations */
+	int64		pinf_count;		/* number of +infinity durations */
+	int64		nfinite;		/* number of finite durations, incl. zero */
+	Duration	min;			/* smallest finite duration, if nfinite > 0 */
+	Duration	max;			/* largest finite duration, if nfinite > 0 */
+} DurationSketchState;
+
+static bool
+duration_sketch_alpha_valid(float8 alpha)
+{
+	return alpha >= DURATION_SKETCH_MIN_ALPHA &&
+		alpha <= DURATION_SKETCH_MAX_ALPHA;
+}
+
+static void
+duration_sketch_check_alpha(float8 alpha)
+{
+	if (!duration_sketch_alpha_valid(alpha))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("relative accuracy %g is not between %g and %g",
+						alpha, DURATION_SKETCH_MIN_ALPHA,
+						DURATION_SKETCH_MAX_ALPHA)));
+}
+
+static float8
+duration_sketch_log_gamma(float8 alpha)
+{
+	return log((1.0 + alpha) / (1.0 - alpha));
+}
+
+/* Number of bins needed for magnitudes up to 2^63 microseconds */
+static int32
+duration_sketch_nbins(float8 alpha)
+{
+	return (int32) ceil(63.0 * M_LN2 / duration_sketch_log_gamma(alpha)) + 1;
+}
+
+/*
+ * Create a sketch state in the current memory context.  alpha must already
+ * have been checked.
+ */
+static DurationSketchState *
+makeDurationSketchState(float8 alpha)
+{
+	DurationSketchState *state;
+
+	state = (DurationSketchState *) palloc0(sizeof(DurationSketchState));
+	state->alpha = alpha;
+	state->log_gamma = duration_sketch_log_gamma(alpha);
+	state->nbins = duration_sketch_nbins(alpha);
+
+	return state;
+}
+
+static int64 *
+duration_sketch_store(DurationSketchState *state, bool negative)
+{
+	int64	  **store = negative ? &state->neg : &state->pos;
+
+	if (*store == NULL)
+		*store = (int64 *) palloc0(state->nbins * sizeof(int64));
+	return *store;
+}
+
+/* Add to a count, failing rather than wrapping around */
+static void
+duration_sketch_count_add(int64 *count, int64 n)
+{
+	if (unlikely(pg_add_s64_overflow(*count, n, count)))
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("duration sketch count out of range")));
+}
+
+static void
+duration_sketch_add(DurationSketchState *state, Duration duration)
+{
+	if (DURATION_IS_NOBEGIN(duration))
+		duration_sketch_count_add(&state->ninf_count, 1);
+	else if (DURATION_IS_NOEND(duration))
+		duration_sketch_count_add(&state->pinf_count, 1);
+	else
+	{
+		if (duration == 0)
+			state->zero_count++;
+		else
+		{
+			bool		negative = duration < 0;
+			int64	   *store = duration_sketch_store(state, negative);
+			float8		magnitude = negative ? -(float8) duration : (float8) duration;
+			int32		index;
+
+			index = (int32) ceil(log(magnitude) / state->log_gamma);
+			index = Min(Max(index, 0), state->nbins - 1);
+			store[index]++;
+		}
+
+		if (state->nfinite == 0 || duration < state->min)
+			state->min = duration;
+		if (state->nfinite == 0 || duration > state->max)
+			state->max = duration;
+		state->nfinite++;
+	}
+}
+
+/*
+ * Merge the counts of sketch into state, which must have the same alpha.
+ */
+static void
+duration_sketch_merge_internal(DurationSketchState *state,
+							   const DurationSketch *sketch)
+{
+	int64		nfinite = sketch->zero_count;
+
+	if (sketch->alpha != state->alpha)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot merge duration sketches with different relative accuracy")));
+
+	for (int i = 0; i < sketch->nneg + sketch->npos; i++)
+	{
+		const DurationSketchBin *bin = &sketch->bins[i];
+		int64	   *store = duration_sketch_store(state, i < sketch->nneg);
+
+		if (bin->index < 0 || bin->index >= state->nbins || bin->count <= 0)
+			elog(ERROR, "invalid duration sketch bin");
+		duration_sketch_count_add(&store[bin->index], bin->count);
+		duration_sketch_count_add(&nfinite, bin->count);
+	}
+
+	duration_sketch_count_add(&state->zero_count, sketch->zero_count);
+	duration_sketch_count_add(&state->ninf_count, sketch->ninf_count);
+	duration_sketch_count_add(&state->pinf_count, sketch->pinf_count);
+
+	if (nfinite > 0)
+	{
+		if (state->nfinite == 0 || sketch->min < state->min)
+			state->min = sketch->min;
+		if (state->nfinite == 0 || sketch->max > state->max)
+			state->max = sketch->max;
+		duration_sketch_count_add(&state->nfinite, nfinite);
+	}
+}
+
+static DurationSketch *
+makeDurationSketch(int32 nneg, int32 npos)
+{
+	Size		size = offsetof(DurationSketch, bins) +
+		((Size) nneg + npos) * sizeof(DurationSketchBin);
+	DurationSketch *sketch = (DurationSketch *) palloc0(size);
+
+	SET_VARSIZE(sketch, size);
+	sketch->nneg = nneg;
+	sketch->npos = npos;
+	return sketch;
+}
+
+static DurationSketch *
+duration_sketch_from_state(const DurationSketchState *state)
+{
+	DurationSketch *sketch;
+	int32		nneg = 0;
+	int32		npos = 0;
+	int			n = 0;
+
+	for (int i = 0; i < state->nbins; i++)
+	{
+		if (state->neg && state->neg[i] != 0)
+			nneg++;
+		if (state->pos && state->pos[i] != 0)
+			npos++;
+	}
+
+	sketch = makeDurationSketch(nneg, npos);
+	sketch->alpha = state->alpha;
+	sketch->zero_count = state->zero_count;
+	sketch->ninf_count = state->ninf_count;
+	sketch->pinf_count = state->pinf_count;
+	if (state->nfinite > 0)
+	{
+		sketch->min = state->min;
+		sketch->max = state->max;
+	}
+
+	for (int i = 0; nneg > 0 && i < state->nbins; i++)
+	{
+		if (state->neg[i] != 0)
+		{
+			sketch->bins[n].index = i;
+			sketch->bins[n].count = state->neg[i];
+			n++;
+		}
+	}
+	for (int i = 0; npos > 0 && i < state->nbins; i++)
+	{
+		if (state->pos[i] != 0)
+		{
+			sketch->bins[n].index = i;
+			sketch->bins[n].count = state->pos[i];
+			n++;
+		}
+	}
+
+	return sketch;
+}
+
+/*
+ * Check a sketch that came from outside, i.e. from text or binary input.
+ * Everything built from it afterwards may assume it is consistent.
+ */
+static bool
+duration_sketch_valid(const DurationSketch *sketch)
+{
+	int32		nbins;
+	bool		has_finite = sketch->zero_count > 0;
+
+	if (!duration_sketch_alpha_valid(sketch->alpha) ||
+		sketch->nneg < 0 || sketch->npos < 0 ||
+		sketch->zero_count < 0 || sketch->ninf_count < 0 ||
+		sketch->pinf_count < 0)
+		return false;
+
+	nbins = duration_sketch_nbins(sketch->alpha);
+	for (int i = 0; i < sketch->nneg + sketch->npos; i++)
+	{
+		const DurationSketchBin *bin = &sketch->bins[i];
+
+		if (bin->index < 0 || bin->index >= nbins || bin->count <= 0)
+			return false;
+		/* bins of each sign must be in strictly ascending order */
+		if (i != 0 && i != sketch->nneg && bin->index <= bin[-1].index)
+			return false;
+		has_finite = true;
+	}
+
+	if (has_finite)
+		return sketch->min <= sketch->max && !DURATION_NOT_FINITE(sketch->min) &&
+			!DURATION_NOT_FINITE(sketch->max);
+	else
+		return sketch->min == 0 && sketch->max == 0;
+}
+
+/* Skip whitespace, then consume str if it comes next */
+static bool
+duration_sketch_parse_token(char **cp, const char *str)
+{
+	size_t		len = strlen(str);
+
+	while (isspace((unsigned char) **cp))
+		(*cp)++;
+	if (strncmp(*cp, str, len) != 0)
+		return false;
+	*cp += len;
+	return true;
+}
+
+static bool
+duration_sketch_parse_int64(char **cp, int64 *result)
+{
+	char	   *end;
+
+	errno = 0;
+	*result = strtoi64(*cp, &end, 10);
+	if (end == *cp || errno != 0)
+		return false;
+	*cp = end;
+	return true;
+}
+
+/*
+ * Parse the bins of one sign, "{index:count,...}", counting them in *nbins.
+ * With bins == NULL, only count them.
+ */
+static bool
+duration_sketch_parse_bins(char **cp, DurationSketchBin *bins, int32 *nbins)
+{
+	*nbins = 0;
+	if (!duration_sketch_parse_token(cp, "{"))
+		return false;
+	if (duration_sketch_parse_token(cp, "}"))
+		return true;
+
+	do
+	{
+		int64		index;
+		int64		count;
+
+		if (!duration_sketch_parse_int64(cp, &index) ||
+			index < 0 || index > PG_INT32_MAX ||
+			!duration_sketch_parse_token(cp, ":") ||
+			!duration_sketch_parse_int64(cp, &count) ||
+			*nbins == PG_INT32_MAX)
+			return false;
+
+		if (bins)
+		{
+			bins[*nbins].index = (int32) index;
+			bins[*nbins].count = count;
+		}
+		(*nbins)++;
+	} while (duration_sketch_parse_token(cp, ","));
+
+	return duration_sketch_parse_token(cp, "}");
+}
+
+/*
+ * Text representation:
+ *
+ *	alpha=0.01 zero=0 ninf=0 pinf=0 min=1000 max=5000 neg={} pos={348:1,...}
+ *
+ * where min and max are microseconds and each bin is index:count.  Parsing
+ * is done twice, first to size the result and then to fill it in.
+ */
+static bool
+duration_sketch_parse(char *str, DurationSketch *sketch,
+					  int32 *nneg, int32 *npos, struct Node *escontext)
+{
+	char	   *cp = str;
+	char	   *end;
+	float8		alpha;
+
+	if (!duration_sketch_parse_token(&cp, "alpha="))
+		return false;
+	alpha = float8in_internal(cp, &end, "duration_sketch", str, escontext);
+	if (SOFT_ERROR_OCCURRED(escontext))
+		return false;
+	cp = end;
+
+	if (sketch)
+	{
+		sketch->alpha = alpha;
+		if (!duration_sketch_parse_token(&cp, "zero=") ||
+			!duration_sketch_parse_int64(&cp, &sketch->zero_count) ||
+			!duration_sketch_parse_token(&cp, "ninf=") ||
+			!duration_sketch_parse_int64(&cp, &sketch->ninf_count) ||
+			!duration_sketch_parse_token(&cp, "pinf=") ||
+			!duration_sketch_parse_int64(&cp, &sketch->pinf_count) ||
+			!duration_sketch_parse_token(&cp, "min=") ||
+			!duration_sketch_parse_int64(&cp, &sketch->min) ||
+			!duration_sketch_parse_token(&cp, "max=") ||
+			!duration_sketch_parse_int64(&cp, &sketch->max))
+			return false;
+	}
+	else
+	{
+		int64		dummy;
+
+		if (!duration_sketch_parse_token(&cp, "zero=") ||
+			!duration_sketch_parse_int64(&cp, &dummy) ||
+			!duration_sketch_parse_token(&cp, "ninf=") ||
+			!duration_sketch_parse_int64(&cp, &dummy) ||
+			!duration_sketch_parse_token(&cp, "pinf=") ||
+			!duration_sketch_parse_int64(&cp, &dummy) ||
+			!duration_sketch_parse_token(&cp, "min=") ||
+			!duration_sketch_parse_int64(&cp, &dummy) ||
+			!duration_sketch_parse_token(&cp, "max=") ||
+			!duration_sketch_parse_int64(&cp, &dummy))
+			return false;
+	}
+
+	if (!duration_sketch_parse_token(&cp, "neg=") ||
+		!duration_sketch_parse_bins(&cp, sketch ? sketch->bins : NULL, nneg) ||
+		!duration_sketch_parse_token(&cp, "pos=") ||
+		!duration_sketch_parse_bins(&cp, sketch ? sketch->bins + *nneg : NULL,
+									npos))
+		return false;
+
+	/* nothing may follow except whitespace */
+	while (isspace((unsigned char) *cp))
+		cp++;
+	return *cp == '\0';
+}
+
+Datum
+duration_sketch_in(PG_FUNCTION_ARGS)
+{
+	char	   *str = PG_GETARG_CSTRING(0);
+	struct Node *escontext = fcinfo->context;
+	DurationSketch *sketch;
+	int32		nneg;
+	int32		npos;
+
+	if (!duration_sketch_parse(str, NULL, &nneg, &npos, escontext))
+	{
+		if (SOFT_ERROR_OCCURRED(escontext))
+			PG_RETURN_NULL();
+		ereturn(escontext, (Datum) 0,
+				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+				 errmsg("invalid input syntax for type %s: \"%s\"",
+						"duration_sketch", str)));
+	}
+
+	sketch = makeDurationSketch(nneg, npos);
+	if (!duration_sketch_parse(str, sketch, &nneg, &npos, escontext) ||
+		!duration_sketch_valid(sketch))
+		ereturn(escontext, (Datum) 0,
+				(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+				 errmsg("invalid duration sketch: \"%s\"", str)));
+
+	PG_RETURN_DURATION_SKETCH_P(sketch);
+}
+
+static void
+duration_sketch_out_bins(StringInfo buf, const DurationSketchBin *bins, int32 n)
+{
+	appendStringInfoChar(buf, '{');
+	for (int i = 0; i < n; i++)
+		appendStringInfo(buf, "%s%d:" INT64_FORMAT, i > 0 ? "," : "",
+						 bins[i].index, bins[i].count);
+	appendStringInfoChar(buf, '}');
+}
+
+Datum
+duration_sketch_out(PG_FUNCTION_ARGS)
+{
+	DurationSketch *sketch = PG_GETARG_DURATION_SKETCH_P(0);
+	StringInfoData buf;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "alpha=%s zero=" INT64_FORMAT " ninf=" INT64_FORMAT
+					 " pinf=" INT64_FORMAT " min=" INT64_FORMAT
+					 " max=" INT64_FORMAT " neg=",
+					 float8out_internal(sketch->alpha), sketch->zero_count,
+					 sketch->ninf_count, sketch->pinf_count,
+					 sketch->min, sketch->max);
+	duration_sketch_out_bins(&buf, sketch->bins, sketch->nneg);
+	appendStringInfoString(&buf, " pos=");
+	duration_sketch_out_bins(&buf, sketch->bins + sketch->nneg, sketch->npos);
+
+	PG_RETURN_CSTRING(buf.data);
+}
+
+Datum
+duration_sketch_recv(PG_FUNCTION_ARGS)
+{
+	StringInfo	buf = (StringInfo) PG_GETARG_POINTER(0);
+	DurationSketch *sketch;
+	float8		alpha = pq_getmsgfloat8(buf);
+	int64		zero_count = pq_getmsgint64(buf);
+	int64		ninf_count = pq_getmsgint64(buf);
+	int64		pinf_count = pq_getmsgint64(buf);
+	Duration	min = pq_getmsgint64(buf);
+	Duration	max = pq_getmsgint64(buf);
+	int32		nneg = pq_getmsgint(buf, 4);
+	int32		npos = pq_getmsgint(buf, 4);
+
+	/* each bin takes 12 bytes, which bounds the plausible count */
+	if (nneg < 0 || npos < 0 ||
+		((int64) nneg + npos) * 12 > buf->len - buf->cursor)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid duration sketch bin count")));
+
+	sketch = makeDurationSketch(nneg, npos);
+	sketch->alpha = alpha;
+	sketch->zero_count = zero_count;
+	sketch->ninf_count = ninf_count;
+	sketch->pinf_count = pinf_count;
+	sketch->min = min;
+	sketch->max = max;
+	for (int i = 0; i < nneg + npos; i++)
+	{
+		sketch->bins[i].index = pq_getmsgint(buf, 4);
+		sketch->bins[i].count = pq_getmsgint64(buf);
+	}
+
+	if (!duration_sketch_valid(sketch))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid duration sketch")));
+
+	PG_RETURN_DURATION_SKETCH_P(sketch);
+}
+
+Datum
+duration_sketch_send(PG_FUNCTION_ARGS)
+{
+	DurationSketch *sketch = PG_GETARG_DURATION_SKETCH_P(0);
+	StringInfoData buf;
+
+	pq_begintypsend(&buf);
+	pq_sendfloat8(&buf, sketch->alpha);
+	pq_sendint64(&buf, sketch->zero_count);
+	pq_sendint64(&buf, sketch->ninf_count);
+	pq_sendint64(&buf, sketch->pinf_count);
+	pq_sendint64(&buf, sketch->min);
+	pq_sendint64(&buf, sketch->max);
+	pq_sendint32(&buf, sketch->nneg);
+	pq_sendint32(&buf, sketch->npos);
+	for (int i = 0; i < sketch->nneg + sketch->npos; i++)
+	{
+		pq_sendint32(&buf, sketch->bins[i].index);
+		pq_sendint64(&buf, sketch->bins[i].count);
+	}
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/*
+ * Transition function for duration_sketch_agg(duration [, float8]).  The
+ * relative accuracy is taken from the first row of each group.
+ */
+Datum
+duration_sketch_accum(PG_FUNCTION_ARGS)
+{
+	DurationSketchState *state;
+	MemoryContext agg_context;
+	MemoryContext old_context;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationSketchState *) PG_GETARG_POINTER(0);
+
+	if (PG_ARGISNULL(1))
+		PG_RETURN_POINTER(state);
+
+	old_context = MemoryContextSwitchTo(agg_context);
+
+	/* Create the state data on the first call */
+	if (state == NULL)
+	{
+		float8		alpha = DURATION_SKETCH_DEFAULT_ALPHA;
+
+		if (PG_NARGS() > 2 && !PG_ARGISNULL(2))
+			alpha = PG_GETARG_FLOAT8(2);
+		duration_sketch_check_alpha(alpha);
+		state = makeDurationSketchState(alpha);
+	}
+
+	duration_sketch_add(state, PG_GETARG_DURATION(1));
+
+	MemoryContextSwitchTo(old_context);
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * Transition function for sketch_merge(duration_sketch).
+ */
+Datum
+duration_sketch_merge_accum(PG_FUNCTION_ARGS)
+{
+	DurationSketchState *state;
+	DurationSketch *sketch;
+	MemoryContext agg_context;
+	MemoryContext old_context;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationSketchState *) PG_GETARG_POINTER(0);
+
+	if (PG_ARGISNULL(1))
+		PG_RETURN_POINTER(state);
+
+	sketch = PG_GETARG_DURATION_SKETCH_P(1);
+
+	old_context = MemoryContextSwitchTo(agg_context);
+
+	if (state == NULL)
+		state = makeDurationSketchState(sketch->alpha);
+	duration_sketch_merge_internal(state, sketch);
+
+	MemoryContextSwitchTo(old_context);
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * Combine function for the sketch aggregates.  Merging goes through the
+ * serialized form, which is no slower than walking two sets of dense bins.
+ */
+Datum
+duration_sketch_combine(PG_FUNCTION_ARGS)
+{
+	DurationSketchState *state1;
+	DurationSketchState *state2;
+	DurationSketch *sketch2;
+	MemoryContext agg_context;
+	MemoryContext old_context;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state1 = PG_ARGISNULL(0) ? NULL : (DurationSketchState *) PG_GETARG_POINTER(0);
+	state2 = PG_ARGISNULL(1) ? NULL : (DurationSketchState *) PG_GETARG_POINTER(1);
+
+	if (state2 == NULL)
+		PG_RETURN_POINTER(state1);
+
+	sketch2 = duration_sketch_from_state(state2);
+
+	old_context = MemoryContextSwitchTo(agg_context);
+
+	if (state1 == NULL)
+		state1 = makeDurationSketchState(state2->alpha);
+	duration_sketch_merge_internal(state1, sketch2);
+
+	MemoryContextSwitchTo(old_context);
+
+	pfree(sketch2);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/*
+ * Serialize a sketch state.  Its serialized form is simply the
+ * duration_sketch it would produce.
+ */
+Datum
+duration_sketch_serialize(PG_FUNCTION_ARGS)
+{
+	DurationSketchState *state;
+
+	/* Ensure we disallow calling when not in aggregate context */
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = (DurationSketchState *) PG_GETARG_POINTER(0);
+
+	PG_RETURN_BYTEA_P(duration_sketch_from_state(state));
+}
+
+Datum
+duration_sketch_deserialize(PG_FUNCTION_ARGS)
+{
+	DurationSketch *sketch;
+	DurationSketchState *result;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	/* Copy, so that the fields are suitably aligned */
+	sketch = (DurationSketch *) PG_DETOAST_DATUM_COPY(PG_GETARG_DATUM(0));
+
+	result = makeDurationSketchState(sketch->alpha);
+	duration_sketch_merge_internal(result, sketch);
+
+	PG_RETURN_POINTER(result);
+}
+
+Datum
+duration_sketch_final(PG_FUNCTION_ARGS)
+{
+	DurationSketchState *state;
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationSketchState *) PG_GETARG_POINTER(0);
+
+	/* If there were no non-null inputs, return NULL */
+	if (state == NULL)
+		PG_RETURN_NULL();
+
+	PG_RETURN_DURATION_SKETCH_P(duration_sketch_from_state(state));
+}
+
+/*
+ * Representative value of a bin: the point with equal relative distance to
+ * both of its bounds, clamped to the finite inputs actually seen.
+ */
+static Duration
+duration_sketch_bin_value(const DurationSketch *sketch, float8 log_gamma,
+						  int32 index, bool negative)
+{
+	float8		gamma = exp(log_gamma);
+	float8		value = 2.0 * exp(index * log_gamma) / (gamma + 1.0);
+
+	if (negative)
+		value = -value;
+	value = Min(Max(value, (float8) sketch->min), (float8) sketch->max);
+
+	return (Duration) rint(value);
+}
+
+/*
+ * quantile(duration_sketch, float8) - approximate quantile
+ *
+ * Returns the input value of rank q * (count - 1), to within the sketch's
+ * relative accuracy.
+ */
+Datum
+duration_sketch_quantile(PG_FUNCTION_ARGS)
+{
+	DurationSketch *sketch = PG_GETARG_DURATION_SKETCH_P(0);
+	float8		quantile = PG_GETARG_FLOAT8(1);
+	float8		log_gamma = duration_sketch_log_gamma(sketch->alpha);
+	float8		rank;
+	int64		count;
+	int64		seen;
+	Duration	result;
+
+	duration_percentile_check(quantile);
+
+	count = sketch->zero_count;
+	duration_sketch_count_add(&count, sketch->ninf_count);
+	duration_sketch_count_add(&count, sketch->pinf_count);
+	for (int i = 0; i < sketch->nneg + sketch->npos; i++)
+		duration_sketch_count_add(&count, sketch->bins[i].count);
+
+	if (count == 0)
+		PG_RETURN_NULL();
+
+	rank = quantile * (count - 1);
+
+	/* Walk the values in ascending order until we pass the rank */
+	seen = sketch->ninf_count;
+	if (seen > rank)
+	{
+		DURATION_NOBEGIN(result);
+		PG_RETURN_DURATION(result);
+	}
+
+	for (int i = sketch->nneg - 1; i >= 0; i--)
+	{
+		seen += sketch->bins[i].count;
+		if (seen > rank)
+			PG_RETURN_DURATION(duration_sketch_bin_value(sketch, log_gamma,
+														 sketch->bins[i].index,
+														 true));
+	}
+
+	seen += sketch->zero_count;
+	if (seen > rank)
+		PG_RETURN_DURATION(0);
+
+	for (int i = sketch->nneg; i < sketch->nneg + sketch->npos; i++)
+	{
+		seen += sketch->bins[i].count;
+		if (seen > rank)
+			PG_RETURN_DURATION(duration_sketch_bin_value(sketch, log_gamma,
+														 sketch->bins[i].index,
+														 false));
+	}
+
+	DURATION_NOEND(result);
+	PG_RETURN_DURATION(result);
+}
+
+/*****************************************************************************
+ *				   Histograms
+ *****************************************************************************/
+
+/*
+ * duration_histogram() counts durations in log-linear buckets, in the style
+ * of HdrHistogram.  Magnitudes below 2^bits microseconds get a bucket each;
+ * above that, every power of two is split into 2^(bits - 1) equal buckets,
+ * so a bucket is never wider than 2^-(bits - 1) of the values in it.  bits is
+ * the smallest number of binary digits that resolves the requested number
+ * of significant decimal digits, as in HdrHistogram.
+ *
+ * Finding a value's bucket takes a shift and a few additions, and the counts
+ * for each power of two are only allocated once a value lands there.
+ */
+#define DURATION_HISTOGRAM_DEFAULT_PRECISION	2
+#define DURATION_HISTOGRAM_MAX_PRECISION		4
+#define DURATION_HISTOGRAM_MAX_BANDS			64
+
+typedef struct DurationHistogramState
+{
+	int32		precision;		/* significant decimal digits */
+	int32		bits;			/* significant binary digits */
+	int32		nbands;			/* number of usable bands */
+	int64		ninf_count;		/* number of -infinity durations */
+	int64		pinf_count;		/* number of +infinity durations */
+
+	/*
+	 * Counts of negative and positive durations by magnitude.  Band 0 covers
+	 * [0, 2^bits) with 2^bits buckets of width 1; band s > 0 covers
+	 * [2^(bits + s - 1), 2^(bits + s)) with 2^(bits - 1) buckets of width 2^s.
+	 * The negative band 0 never counts zero.
+	 */
+	int64	   *neg[DURATION_HISTOGRAM_MAX_BANDS];
+	int64	   *pos[DURATION_HISTOGRAM_MAX_BANDS];
+} DurationHistogramState;
+
+static int32
+duration_histogram_band_size(const DurationHistogramState *state, int band)
+{
+	return band == 0 ? 1 << state->bits : 1 << (state->bits - 1);
+}
+
+static DurationHistogramState *
+makeDurationHistogramState(int32 precision)
+{
+	DurationHistogramState *state;
+	int32		bits;
+
+	if (precision < 1 || precision > DURATION_HISTOGRAM_MAX_PRECISION)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("histogram precision %d is not between 1 and %d",
+						precision, DURATION_HISTOGRAM_MAX_PRECISION)));
+
+	/* bits = ceil(log2(2 * 10^precision)) */
+	bits = (int32) ceil(log2(2.0 * pow(10.0, precision)));
+
+	state = (DurationHistogramState *) palloc0(sizeof(DurationHistogramState));
+	state->precision = precision;
+	state->bits = bits;
+	/* magnitudes are below 2^63, so the last band is 63 - bits */
+	state->nbands = 64 - bits;
+
+	return state;
+}
+
+/*
+ * Find the band and bucket of a magnitude.
+ */
+static inline void
+duration_histogram_locate(const DurationHistogramState *state, uint64 magnitude,
+						  int *band, int32 *bucket)
+{
+	int			shift;
+
+	if (magnitude < (UINT64CONST(1) << state->bits))
+	{
+		*band = 0;
+		*bucket = (int32) magnitude;
+		return;
+	}
+
+	shift = pg_leftmost_one_pos64(magnitude) + 1 - state->bits;
+	*band = shift;
+	*bucket = (int32) (magnitude >> shift) - (1 << (state->bits - 1));
+}
+
+/* The smallest magnitude in a bucket */
+static uint64
+duration_histogram_bucket_lower(const DurationHistogramState *state, int band,
+								int32 bucket)
+{
+	if (band == 0)
+		return (uint64) bucket;
+	return ((uint64) bucket + (UINT64CONST(1) << (state->bits - 1))) << band;
+}
+
+static int64 *
+duration_histogram_counts(DurationHistogramState *state, bool negative,
+						  int band)
+{
+	int64	  **counts = negative ? &state->neg[band] : &state->pos[band];
+
+	if (*counts == NULL)
+		*counts = (int64 *) palloc0(duration_histogram_band_size(state, band) *
+									sizeof(int64));
+	return *counts;
+}
+
+static void
+duration_histogram_add(DurationHistogramState *state, Duration duration,
+					   int64 n)
+{
+	int64	   *count;
+
+	if (DURATION_IS_NOBEGIN(duration))
+		count = &state->ninf_count;
+	else if (DURATION_IS_NOEND(duration))
+		count = &state->pinf_count;
+	else
+	{
+		bool		negative = duration < 0;
+		uint64		magnitude = negative ? -(uint64) duration : (uint64) duration;
+		int			band;
+		int32		bucket;
+
+		duration_histogram_locate(state, magnitude, &band, &bucket);
+		count = &duration_histogram_counts(state, negative, band)[bucket];
+	}
+
+	if (unlikely(pg_add_s64_overflow(*count, n, count)))
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("histogram count out of range")));
+}
+
+/*
+ * Transition function for duration_histogram(duration [, int4]).  The
+ * precision is taken from the first row of each group.
+ */
+Datum
+duration_histogram_accum(PG_FUNCTION_ARGS)
+{
+	DurationHistogramState *state;
+	MemoryContext agg_context;
+	MemoryContext old_context;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationHistogramState *) PG_GETARG_POINTER(0);
+
+	if (PG_ARGISNULL(1))
+		PG_RETURN_POINTER(state);
+
+	old_context = MemoryContextSwitchTo(agg_context);
+
+	/* Create the state data on the first call */
+	if (state == NULL)
+	{
+		int32		precision = DURATION_HISTOGRAM_DEFAULT_PRECISION;
+
+		if (PG_NARGS() > 2 && !PG_ARGISNULL(2))
+			precision = PG_GETARG_INT32(2);
+		state = makeDurationHistogramState(precision);
+	}
+
+	duration_histogram_add(state, PG_GETARG_DURATION(1), 1);
+
+	MemoryContextSwitchTo(old_context);
+
+	PG_RETURN_POINTER(state);
+}
+
+Datum
+duration_histogram_combine(PG_FUNCTION_ARGS)
+{
+	DurationHistogramState *state1;
+	DurationHistogramState *state2;
+	MemoryContext agg_context;
+	MemoryContext old_context;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state1 = PG_ARGISNULL(0) ? NULL : (DurationHistogramState *) PG_GETARG_POINTER(0);
+	state2 = PG_ARGISNULL(1) ? NULL : (DurationHistogramState *) PG_GETARG_POINTER(1);
+
+	if (state2 == NULL)
+		PG_RETURN_POINTER(state1);
+
+	old_context = MemoryContextSwitchTo(agg_context);
+
+	if (state1 == NULL)
+		state1 = makeDurationHistogramState(state2->precision);
+	else if (state1->precision != state2->precision)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot combine histograms with different precision")));
+
+	state1->ninf_count += state2->ninf_count;
+	state1->pinf_count += state2->pinf_count;
+	for (int band = 0; band < state2->nbands; band++)
+	{
+		int32		size = duration_histogram_band_size(state2, band);
+
+		for (int sign = 0; sign < 2; sign++)
+		{
+			int64	   *counts2 = sign ? state2->neg[band] : state2->pos[band];
+			int64	   *counts1;
+
+			if (counts2 == NULL)
+				continue;
+			counts1 = duration_histogram_counts(state1, sign, band);
+			for (int32 i = 0; i < size; i++)
+			{
+				if (unlikely(pg_add_s64_overflow(counts1[i], counts2[i],
+												 &counts1[i])))
+					ereport(ERROR,
+							(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+							 errmsg("histogram count out of range")));
+			}
+		}
+	}
+
+	MemoryContextSwitchTo(old_context);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/*
+ * Serialize a histogram state as its precision, the infinite counts and then
+ * the value and count of each nonempty bucket, using the bucket's smallest
+ * value to stand for it.
+ */
+Datum
+duration_histogram_serialize(PG_FUNCTION_ARGS)
+{
+	DurationHistogramState *state;
+	StringInfoData buf;
+
+	/* Ensure we disallow calling when not in aggregate context */
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = (DurationHistogramState *) PG_GETARG_POINTER(0);
+
+	pq_begintypsend(&buf);
+	pq_sendint32(&buf, state->precision);
+	pq_sendint64(&buf, state->ninf_count);
+	pq_sendint64(&buf, state->pinf_count);
+
+	for (int band = 0; band < state->nbands; band++)
+	{
+		int32		size = duration_histogram_band_size(state, band);
+
+		for (int sign = 0; sign < 2; sign++)
+		{
+			int64	   *counts = sign ? state->neg[band] : state->pos[band];
+
+			if (counts == NULL)
+				continue;
+			for (int32 i = 0; i < size; i++)
+			{
+				uint64		lower;
+
+				if (counts[i] == 0)
+					continue;
+				lower = duration_histogram_bucket_lower(state, band, i);
+				pq_sendint64(&buf, sign ? -(int64) lower : (int64) lower);
+				pq_sendint64(&buf, counts[i]);
+			}
+		}
+	}
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+Datum
+duration_histogram_deserialize(PG_FUNCTION_ARGS)
+{
+	bytea	   *sstate;
+	DurationHistogramState *result;
+	StringInfoData buf;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	sstate = PG_GETARG_BYTEA_PP(0);
+
+	/*
+	 * Initialize a StringInfo so that we can "receive" it using the standard
+	 * recv-function infrastructure.
+	 */
+	initReadOnlyStringInfo(&buf, VARDATA_ANY(sstate),
+						   VARSIZE_ANY_EXHDR(sstate));
+
+	result = makeDurationHistogramState(pq_getmsgint(&buf, 4));
+	result->ninf_count = pq_getmsgint64(&buf);
+	result->pinf_count = pq_getmsgint64(&buf);
+
+	while (buf.cursor < buf.len)
+	{
+		Duration	value = pq_getmsgint64(&buf);
+
+		duration_histogram_add(result, value, pq_getmsgint64(&buf));
+	}
+
+	pq_getmsgend(&buf);
+
+	PG_RETURN_POINTER(result);
+}
+
+/*
+ * Append a bucket to the result arrays.  upper is exclusive, except that
+ * the buckets of the infinities have both bounds infinite.
+ */
+static void
+duration_histogram_emit(Datum *lower, Datum *upper, Datum *counts, int *n,
+						Duration lo, Duration hi, int64 count)
+{
+	lower[*n] = DurationGetDatum(lo);
+	upper[*n] = DurationGetDatum(hi);
+	counts[*n] = Int64GetDatum(count);
+	(*n)++;
+}
+
+/*
+ * Final function: a duration_histogram with the bounds and count of every
+ * nonempty bucket, in ascending order.
+ */
+Datum
+duration_histogram_final(PG_FUNCTION_ARGS)
+{
+	DurationHistogramState *state;
+	TupleDesc	tupdesc;
+	Datum	   *lower;
+	Datum	   *upper;
+	Datum	   *counts;
+	int			nbuckets = 0;
+	int			n = 0;
+	Oid			arraytype;
+	Duration	nobegin;
+	Duration	noend;
+	Datum		values[3];
+	bool		nulls[3] = {false, false, false};
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationHistogramState *) PG_GETARG_POINTER(0);
+
+	/* If there were no non-null inputs, return NULL */
+	if (state == NULL)
+		PG_RETURN_NULL();
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	nbuckets = (state->ninf_count > 0) + (state->pinf_count > 0);
+	for (int band = 0; band < state->nbands; band++)
+	{
+		int32		size = duration_histogram_band_size(state, band);
+
+		for (int32 i = 0; i < size; i++)
+		{
+			nbuckets += state->neg[band] && state->neg[band][i] != 0;
+			nbuckets += state->pos[band] && state->pos[band][i] != 0;
+		}
+	}
+
+	lower = (Datum *) palloc(nbuckets * sizeof(Datum));
+	upper = (Datum *) palloc(nbuckets * sizeof(Datum));
+	counts = (Datum *) palloc(nbuckets * sizeof(Datum));
+
+	DURATION_NOBEGIN(nobegin);
+	DURATION_NOEND(noend);
+
+	if (state->ninf_count > 0)
+		duration_histogram_emit(lower, upper, counts, &n,
+								nobegin, nobegin, state->ninf_count);
+
+	/* negative buckets, largest magnitude first */
+	for (int band = state->nbands - 1; band >= 0; band--)
+	{
+		if (state->neg[band] == NULL)
+			continue;
+		for (int32 i = duration_histogram_band_size(state, band) - 1; i >= 0; i--)
+		{
+			uint64		lo;
+
+			if (state->neg[band][i] == 0)
+				continue;
+			lo = duration_histogram_bucket_lower(state, band, i);
+			/* magnitudes [lo, lo + width) are values (-lo - width, -lo] */
+			duration_histogram_emit(lower, upper, counts, &n,
+									-(int64) (lo + (UINT64CONST(1) << band) - 1),
+									-(int64) lo + 1,
+									state->neg[band][i]);
+		}
+	}
+
+	for (int band = 0; band < state->nbands; band++)
+	{
+		if (state->pos[band] == NULL)
+			continue;
+		for (int32 i = 0; i < duration_histogram_band_size(state, band); i++)
+		{
+			uint64		lo;
+			uint64		hi;
+
+			if (state->pos[band][i] == 0)
+				continue;
+			lo = duration_histogram_bucket_lower(state, band, i);
+			hi = lo + (UINT64CONST(1) << band);
+			/* the last bucket's upper bound would be 2^63; it is infinity */
+			duration_histogram_emit(lower, upper, counts, &n,
+									(int64) lo, (int64) Min(hi, (uint64) noend),
+									state->pos[band][i]);
+		}
+	}
+
+	if (state->pinf_count > 0)
+		duration_histogram_emit(lower, upper, counts, &n,
+								noend, noend, state->pinf_count);
+
+	Assert(n == nbuckets);
+
+	arraytype = TupleDescAttr(tupdesc, 0)->atttypid;
+	values[0] = PointerGetDatum(construct_array(lower, n,
+												get_element_type(arraytype),
+												sizeof(Duration),
+												FLOAT8PASSBYVAL,
+												TYPALIGN_DOUBLE));
+	values[1] = PointerGetDatum(construct_array(upper, n,
+												get_element_type(arraytype),
+												sizeof(Duration),
+												FLOAT8PASSBYVAL,
+												TYPALIGN_DOUBLE));
+	values[2] = PointerGetDatum(construct_array_builtin(counts, n, INT8OID));
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/*****************************************************************************
+ *				   Set-returning functions
+ *****************************************************************************/
+
+/*
+ * Both generate_series() variants step an int64 by an int64: a duration by a
+ * duration, or a timestamp by a duration, with no calendar arithmetic.
+ */
+typedef struct
+{
+	int64		current;
+	int64		finish;
+	int64		step;
+	bool		done;
+} generate_series_duration_fctx;
+
+static Datum
+generate_series_duration_internal(FunctionCallInfo fcinfo)
+{
+	FuncCallContext *funcctx;
+	generate_series_duration_fctx *fctx;
+	int64		result;
+
+	/* stuff done only on the first call of the function */
+	if (SRF_IS_FIRSTCALL())
+	{
+		int64		start = PG_GETARG_INT64(0);
+		int64		finish = PG_GETARG_INT64(1);
+		Duration	step = PG_GETARG_DURATION(2);
+		MemoryContext oldcontext;
+
+		if (step == 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("step size cannot equal zero")));
+		if (DURATION_NOT_FINITE(step))
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("step size cannot be infinite")));
+
+		/*
+		 * Durations and timestamps use the same values for their infinities.
+		 * Stepping from or towards one would never end.
+		 */
+		if (DURATION_NOT_FINITE(start))
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("start value cannot be infinity")));
+		if (DURATION_NOT_FINITE(finish))
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("stop value cannot be infinity")));
+
+		/* create a function context for cross-call persistence */
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		/*
+		 * switch to memory context appropriate for multiple function calls
+		 */
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		/* allocate memory for user context */
+		fctx = (generate_series_duration_fctx *)
+			palloc(sizeof(generate_series_duration_fctx));
+
+		fctx->current = start;
+		fctx->finish = finish;
+		fctx->step = step;
+		fctx->done = step > 0 ? start > finish : start < finish;
+
+		funcctx->user_fctx = fctx;
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	/* stuff done on every call of the function */
+	funcctx = SRF_PERCALL_SETUP();
+
+	/*
+	 * get the saved state and use current as the result for this iteration
+	 */
+	fctx = funcctx->user_fctx;
+	if (fctx->done)
+		SRF_RETURN_DONE(funcctx);
+
+	result = fctx->current;
+
+	/* increment current in preparation for next iteration */
+	if (pg_add_s64_overflow(fctx->current, fctx->step, &fctx->current))
+		fctx->done = true;
+	else if (fctx->step > 0 ? fctx->current > fctx->finish :
+			 fctx->current < fctx->finish)
+		fctx->done = true;
+
+	/* do when there is more left to send */
+	SRF_RETURN_NEXT(funcctx, Int64GetDatum(result));
+}
+
+/*
+ * generate_series(duration, duration, duration)
+ */
+Datum
+generate_series_duration(PG_FUNCTION_ARGS)
+{
+	return generate_series_duration_internal(fcinfo);
+}
+
+/*
+ * generate_series(timestamptz, timestamptz, duration)
+ */
+Datum
+generate_series_timestamptz_duration(PG_FUNCTION_ARGS)
+{
+	return generate_series_duration_internal(fcinfo);
+}
+
+/*
+ * Planner support function for both generate_series() variants.  With
+ * constant arguments, the number of rows is known exactly.
+ */
+Datum
+generate_series_duration_support(PG_FUNCTION_ARGS)
+{
+	Node	   *rawreq = (Node *) PG_GETARG_POINTER(0);
+	Node	   *ret = NULL;
+
+	if (IsA(rawreq, SupportRequestRows))
+	{
+		/* Try to estimate the number of rows returned */
+		SupportRequestRows *req = (SupportRequestRows *) rawreq;
+
+		if (is_funcclause(req->node))	/* be paranoid */
+		{
+			List	   *args = ((FuncExpr *) req->node)->args;
+			Node	   *arg1,
+					   *arg2,
+					   *arg3;
+
+			/* We can use estimated argument values here */
+			arg1 = estimate_expression_value(req->root, linitial(args));
+			arg2 = estimate_expression_value(req->root, lsecond(args));
+			arg3 = estimate_expression_value(req->root, lthird(args));
+
+			/*
+			 * If any argument is constant NULL, we can safely assume that
+			 * zero rows are returned.  Otherwise, if they're all non-NULL
+			 * constants, we can calculate the number of rows that will be
+			 * returned.
+			 */
+			if ((IsA(arg1, Const) && ((Const *) arg1)->constisnull) ||
+				(IsA(arg2, Const) && ((Const *) arg2)->constisnull) ||
+				(IsA(arg3, Const) && ((Const *) arg3)->constisnull))
+			{
+				req->rows = 0;
+				ret = (Node *) req;
+			}
+			else if (IsA(arg1, Const) && IsA(arg2, Const) && IsA(arg3, Const))
+			{
+				int64		start = DatumGetInt64(((Const *) arg1)->constvalue);
+				int64		finish = DatumGetInt64(((Const *) arg2)->constvalue);
+				int64		step = DatumGetInt64(((Const *) arg3)->constvalue);
+
+				/* Leave the error cases to the function itself */
+				if (step != 0 && !DURATION_NOT_FINITE(step) &&
+					!DURATION_NOT_FINITE(start) && !DURATION_NOT_FINITE(finish))
+				{
+					if (step > 0 ? start > finish : start < finish)
+						req->rows = 0;
+					else if (step > 0)
+						req->rows = (double) (((uint64) finish - (uint64) start) /
+											  (uint64) step) + 1;
+					else
+						req->rows = (double) (((uint64) start - (uint64) finish) /
+											  -(uint64) step) + 1;
+					ret = (Node *) req;
+				}
+			}
+		}
+	}
+
+	PG_RETURN_POINTER(ret);
+}
+
+/*****************************************************************************
+ *				   Planner support for truncated comparisons
+ *****************************************************************************/
+
+/*
+ * duration_trunc_step
+ *
+ *	Width in microseconds of the buckets that date_trunc(unit, duration)
+ *	produces, or zero if the unit is not one duration_trunc accepts.
+ */
+static int64
+duration_trunc_step(text *units)
+{
+	char	   *lowunits;
+	int			type,
+				val;
+
+	lowunits = downcase_truncate_identifier(VARDATA_ANY(units),
+											VARSIZE_ANY_EXHDR(units),
+											false);
+
+	type = DecodeUnits(0, lowunits, &val);
+	if (type != UNITS)
+		return 0;
+
+	switch (val)
+	{
+		case DTK_HOUR:
+			return USECS_PER_HOUR;
+		case DTK_MINUTE:
+			return USECS_PER_MINUTE;
+		case DTK_SECOND:
+			return USECS_PER_SEC;
+		case DTK_MILLISEC:
+			return INT64CONST(1000);
+		case DTK_MICROSEC:
+			return INT64CONST(1);
+		default:
+			return 0;
+	}
+}
+
+/*
+ * duration_trunc_lower
+ *
+ *	Smallest duration x for which date_trunc() with the given step yields a
+ *	value >= finite bound.  Truncation is towards zero, so the bucket for a
+ *	positive multiple m of step is [m, m + step) while the bucket for a
+ *	non-positive one is (m - step, m].  Bounds beyond the finite range clamp
+ *	to +infinity (nothing finite qualifies) or to the smallest finite
+ *	duration (everything finite qualifies).
+ */
+static Duration
+duration_trunc_lower(int64 bound, int64 step)
+{
+	int64		q = bound / step;
+	int64		m;
+
+	/* smallest multiple of step that is >= bound */
+	if (bound > 0 && bound % step != 0)
+		q++;
+	if (pg_mul_s64_overflow(q, step, &m))
+		return PG_INT64_MAX;
+
+	if (m > 0)
+		return m;
+
+	if (pg_sub_s64_overflow(m, step - 1, &m) || DURATION_IS_NOBEGIN(m))
+		return PG_INT64_MIN + 1;
+
+	return m;
+}
+
+/*
+ * Is "node" a call of date_trunc(const unit, duration) that we understand?
+ * If so, return the truncated expression and the bucket width.
+ */
+static bool
+duration_trunc_match(Node *node, Node **arg, int64 *step)
+{
+	FuncExpr   *func;
+	Const	   *units;
+	FmgrInfo	flinfo;
+
+	if (!is_funcclause(node))
+		return false;
+
+	func = (FuncExpr *) node;
+	if (list_length(func->args) != 2 || !IsA(linitial(func->args), Const))
+		return false;
+
+	units = (Const *) linitial(func->args);
+	if (units->constisnull || units->consttype != TEXTOID)
+		return false;
+
+	fmgr_info(func->funcid, &flinfo);
+	if (flinfo.fn_addr != duration_trunc)
+		return false;
+
+	/* the argument is evaluated once per range bound after the rewrite */
+	*arg = (Node *) lsecond(func->args);
+	if (contain_volatile_functions(*arg))
+		return false;
+
+	*step = duration_trunc_step(DatumGetTextPP(units->constvalue));
+	return *step != 0;
+}
+
+static Node *
+make_duration_opclause(Oid opfamily, Oid typid, int16 strategy,
+					   Node *arg, Duration value)
+{
+	Oid			opno = get_opfamily_member(opfamily, typid, typid, strategy);
+	OpExpr	   *op;
+
+	if (!OidIsValid(opno))
+		elog(ERROR, "missing operator %d(%u,%u) in opfamily %u",
+			 strategy, typid, typid, opfamily);
+
+	op = (OpExpr *) make_opclause(opno, BOOLOID, false, (Expr *) arg,
+								  (Expr *) makeConst(typid, -1, InvalidOid,
+													 sizeof(Duration),
+													 DurationGetDatum(value),
+													 false, FLOAT8PASSBYVAL),
+								  InvalidOid, InvalidOid);
+	set_opfuncid(op);
+
+	return (Node *) op;
+}
+
+/*
+ * Planner support function for the duration comparison operators.
+ *
+ * A predicate such as date_trunc('second', d) = '2 s' cannot use an index on
+ * d, and is estimated with a default selectivity.  When one side is a call
+ * of date_trunc with a constant unit and the other a finite constant, rewrite
+ * the comparison into bounds on d itself; here d >= '2 s' AND d < '3 s'.
+ * The resulting range clauses are indexable, and clauselist_selectivity
+ * recognizes the pair and estimates it from the histogram of d.
+ *
+ * Inequality (<>) is left alone: its rewrite would be a disjunction, which
+ * helps neither indexing nor estimation.
+ */
+Datum
+duration_cmp_support(PG_FUNCTION_ARGS)
+{
+	Node	   *rawreq = (Node *) PG_GETARG_POINTER(0);
+	Node	   *ret = NULL;
+
+	if (IsA(rawreq, SupportRequestSimplify))
+	{
+		SupportRequestSimplify *req = (SupportRequestSimplify *) rawreq;
+		FuncExpr   *expr = req->fcall;
+		Node	   *left,
+				   *right,
+				   *arg;
+		Const	   *other;
+		int64		step;
+		Duration	bound,
+					lower,
+					upper;
+		bool		commuted;
+		FmgrInfo	flinfo;
+		PGFunction	cmp;
+		Oid			typid,
+					opfamily;
+
+		Assert(list_length(expr->args) == 2);
+		left = linitial(expr->args);
+		right = lsecond(expr->args);
+
+		if (IsA(right, Const) && duration_trunc_match(left, &arg, &step))
+		{
+			other = (Const *) right;
+			commuted = false;
+		}
+		else if (IsA(left, Const) && duration_trunc_match(right, &arg, &step))
+		{
+			other = (Const *) left;
+			commuted = true;
+		}
+		else
+			PG_RETURN_POINTER(NULL);
+
+		if (other->constisnull)
+			PG_RETURN_POINTER(NULL);
+
+		bound = DatumGetDuration(other->constvalue);
+		if (DURATION_NOT_FINITE(bound))
+			PG_RETURN_POINTER(NULL);
+
+		/*
+		 * date_trunc() never maps a finite duration to an infinite one, so
+		 * the lower edge of the buckets >= bound + 1 is also the upper edge
+		 * of the buckets <= bound.
+		 */
+		lower = duration_trunc_lower(bound, step);
+		upper = duration_trunc_lower(bound + 1, step);
+
+		typid = exprType(arg);
+		opfamily = get_opclass_family(GetDefaultOpClass(typid, BTREE_AM_OID));
+		if (!OidIsValid(opfamily))
+			PG_RETURN_POINTER(NULL);
+
+		/* compare by address, the SQL-level names are not reliable */
+		fmgr_info(expr->funcid, &flinfo);
+		cmp = flinfo.fn_addr;
+		if (commuted)
+		{
+			if (cmp == duration_lt)
+				cmp = duration_gt;
+			else if (cmp == duration_le)
+				cmp = duration_ge;
+			else if (cmp == duration_gt)
+				cmp = duration_lt;
+			else if (cmp == duration_ge)
+				cmp = duration_le;
+		}
+
+		if (cmp == duration_lt)
+			ret = make_duration_opclause(opfamily, typid, BTLessStrategyNumber,
+										 arg, lower);
+		else if (cmp == duration_ge)
+			ret = make_duration_opclause(opfamily, typid,
+										 BTGreaterEqualStrategyNumber,
+										 arg, lower);
+		else if (cmp == duration_le)
+			ret = make_duration_opclause(opfamily, typid, BTLessStrategyNumber,
+										 arg, upper);
+		else if (cmp == duration_gt)
+			ret = make_duration_opclause(opfamily, typid,
+										 BTGreaterEqualStrategyNumber,
+										 arg, upper);
+		else if (cmp == duration_eq)
+		{
+			Node	   *ge = make_duration_opclause(opfamily, typid,
+													BTGreaterEqualStrategyNumber,
+													arg, lower);
+			Node	   *lt = make_duration_opclause(opfamily, typid,
+													BTLessStrategyNumber,
+													copyObject(arg), upper);
+
+			ret = (Node *) make_andclause(list_make2(ge, lt));
+		}
+	}
+
+	PG_RETURN_POINTER(ret);
+}
+
+/*****************************************************************************
+ *				   Bigint conversions and comparisons
+ *****************************************************************************/
+
+/*
+ * A duration is stored as a bigint count of microseconds.  The casts go
+ * through to_duration_micros and duration_to_micros, so that neither the
+ * bigint extremes nor the infinities they represent silently turn into each
+ * other.  Comparisons between the two types need no conversion at all: they
+ * compare the raw counts, so the bigint extremes compare equal to the
+ * infinities, which keeps them consistent with hashing and with interval.
+ */
+
+/*
+ * to_duration_nanos - duration from a count of nanoseconds, rounded half away
+ * from zero.  Every bigint count fits in a finite duration.
+ */
+Datum
+to_duration_nanos(PG_FUNCTION_ARGS)
+{
+	int64		nanos = PG_GETARG_INT64(0);
+	Duration	result;
+
+	result = nanos / 1000;
+	if (nanos % 1000 >= 500)
+		result++;
+	else if (nanos % 1000 <= -500)
+		result--;
+
+	PG_RETURN_DURATION(result);
+}
+
+Datum
+to_duration_micros(PG_FUNCTION_ARGS)
+{
+	int64		micros = PG_GETARG_INT64(0);
+
+	if (micros == PG_INT64_MIN || micros == PG_INT64_MAX)
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("cannot convert bigint %lld to a finite duration",
+						(long long) micros)));
+
+	PG_RETURN_DURATION(micros);
+}
+
+Datum
+duration_to_micros(PG_FUNCTION_ARGS)
+{
+	Duration	duration = PG_GETARG_DURATION(0);
+
+	if (DURATION_NOT_FINITE(duration))
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("cannot convert infinite duration to bigint")));
+
+	PG_RETURN_INT64(duration);
+}
+
+Datum
+duration_int8_cmp(PG_FUNCTION_ARGS)
+{
+	Duration	a = PG_GETARG_DURATION(0);
+	int64		b = PG_GETARG_INT64(1);
+
+	if (a < b)
+		PG_RETURN_INT32(-1);
+	else if (a > b)
+		PG_RETURN_INT32(1);
+	else
+		PG_RETURN_INT32(0);
+}
+
+Datum
+duration_lt_int8(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(PG_GETARG_DURATION(0) < PG_GETARG_INT64(1));
+}
+
+Datum
+duration_le_int8(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(PG_GETARG_DURATION(0) <= PG_GETARG_INT64(1));
+}
+
+Datum
+duration_gt_int8(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(PG_GETARG_DURATION(0) > PG_GETARG_INT64(1));
+}
+
+Datum
+duration_ge_int8(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(PG_GETARG_DURATION(0) >= PG_GETARG_INT64(1));
+}
+
+Datum
+duration_eq_int8(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(PG_GETARG_DURATION(0) == PG_GETARG_INT64(1));
+}
+
+Datum
+duration_ne_int8(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(PG_GETARG_DURATION(0) != PG_GETARG_INT64(1));
+}
+
+Datum
+int8_duration_cmp(PG_FUNCTION_ARGS)
+{
+	int64		a = PG_GETARG_INT64(0);
+	Duration	b = PG_GETARG_DURATION(1);
+
+	if (a < b)
+		PG_RETURN_INT32(-1);
+	else if (a > b)
+		PG_RETURN_INT32(1);
+	else
+		PG_RETURN_INT32(0);
+}
+
+Datum
+int8_lt_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(PG_GETARG_INT64(0) < PG_GETARG_DURATION(1));
+}
+
+Datum
+int8_le_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(PG_GETARG_INT64(0) <= PG_GETARG_DURATION(1));
+}
+
+Datum
+int8_gt_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(PG_GETARG_INT64(0) > PG_GETARG_DURATION(1));
+}
+
+Datum
+int8_ge_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(PG_GETARG_INT64(0) >= PG_GETARG_DURATION(1));
+}
+
+Datum
+int8_eq_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(PG_GETARG_INT64(0) == PG_GETARG_DURATION(1));
+}
+
+Datum
+int8_ne_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(PG_GETARG_INT64(0) != PG_GETARG_DURATION(1));
+}
+
+/*****************************************************************************
+ *				   Interval comparisons
+ *****************************************************************************/
+
+/*
+ * Comparisons against interval follow interval_cmp(), which treats a month
+ * as 30 days and a day as 24 hours, so a duration compares exactly as its
+ * implicit cast to interval would: duration '720 hours' = interval '1 month'.
+ * Doing it here avoids the palloc per row of the cast and lets the
+ * comparison use duration indexes.
+ */
+
+/*
+ * interval_span - the 128-bit microsecond span interval_cmp() sorts by
+ */
+static inline INT128
+interval_span(const Interval *interval)
+{
+	INT128		span;
+	int64		days;
+
+	span = int64_to_int128(interval->time);
+	days = interval->month * INT64CONST(30);
+	days += interval->day;
+	int128_add_int64_mul_int64(&span, days, USECS_PER_DAY);
+
+	return span;
+}
+
+/*
+ * duration_span - the span of a duration cast to interval
+ */
+static inline INT128
+duration_span(Duration duration)
+{
+	Interval	infinity;
+
+	if (!DURATION_NOT_FINITE(duration))
+		return int64_to_int128(duration);
+
+	if (DURATION_IS_NOBEGIN(duration))
+		INTERVAL_NOBEGIN(&infinity);
+	else
+		INTERVAL_NOEND(&infinity);
+
+	return interval_span(&infinity);
+}
+
+static int
+duration_interval_cmp_internal(Duration a, const Interval *b)
+{
+	return int128_compare(duration_span(a), interval_span(b));
+}
+
+Datum
+duration_interval_cmp(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_INT32(duration_interval_cmp_internal(PG_GETARG_DURATION(0),
+												   PG_GETARG_INTERVAL_P(1)));
+}
+
+Datum
+duration_lt_interval(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(duration_interval_cmp_internal(PG_GETARG_DURATION(0),
+												  PG_GETARG_INTERVAL_P(1)) < 0);
+}
+
+Datum
+duration_le_interval(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(duration_interval_cmp_internal(PG_GETARG_DURATION(0),
+												  PG_GETARG_INTERVAL_P(1)) <= 0);
+}
+
+Datum
+duration_gt_interval(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(duration_interval_cmp_internal(PG_GETARG_DURATION(0),
+												  PG_GETARG_INTERVAL_P(1)) > 0);
+}
+
+Datum
+duration_ge_interval(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(duration_interval_cmp_internal(PG_GETARG_DURATION(0),
+												  PG_GETARG_INTERVAL_P(1)) >= 0);
+}
+
+Datum
+duration_eq_interval(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(duration_interval_cmp_internal(PG_GETARG_DURATION(0),
+												  PG_GETARG_INTERVAL_P(1)) == 0);
+}
+
+Datum
+duration_ne_interval(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(duration_interval_cmp_internal(PG_GETARG_DURATION(0),
+												  PG_GETARG_INTERVAL_P(1)) != 0);
+}
+
+Datum
+interval_duration_cmp(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_INT32(-duration_interval_cmp_internal(PG_GETARG_DURATION(1),
+													PG_GETARG_INTERVAL_P(0)));
+}
+
+Datum
+interval_lt_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(duration_interval_cmp_internal(PG_GETARG_DURATION(1),
+												  PG_GETARG_INTERVAL_P(0)) > 0);
+}
+
+Datum
+interval_le_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(duration_interval_cmp_internal(PG_GETARG_DURATION(1),
+												  PG_GETARG_INTERVAL_P(0)) >= 0);
+}
+
+Datum
+interval_gt_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(duration_interval_cmp_internal(PG_GETARG_DURATION(1),
+												  PG_GETARG_INTERVAL_P(0)) < 0);
+}
+
+Datum
+interval_ge_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(duration_interval_cmp_internal(PG_GETARG_DURATION(1),
+												  PG_GETARG_INTERVAL_P(0)) <= 0);
+}
+
+Datum
+interval_eq_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(duration_interval_cmp_internal(PG_GETARG_DURATION(1),
+												  PG_GETARG_INTERVAL_P(0)) == 0);
+}
+
+Datum
+interval_ne_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_BOOL(duration_interval_cmp_internal(PG_GETARG_DURATION(1),
+												  PG_GETARG_INTERVAL_P(0)) != 0);
+}
+
+/*
+ * duration_hash_interval - hash an interval compatibly with hash_duration
+ *
+ * interval_hash() hashes the low 64 bits of the span, which matches
+ * hash_duration() for every finite value but not for the infinities, whose
+ * interval spans do not fit in 64 bits.  The duration hash opfamily uses this
+ * function for interval instead, so that equal values always hash alike.
+ */
+static int64
+interval_hash_key(const Interval *interval)
+{
+	if (INTERVAL_IS_NOBEGIN(interval))
+		return PG_INT64_MIN;
+	else if (INTERVAL_IS_NOEND(interval))
+		return PG_INT64_MAX;
+	else
+		return int128_to_int64(interval_span(interval));
+}
+
+Datum
+duration_hash_interval(PG_FUNCTION_ARGS)
+{
+	int64		key = interval_hash_key(PG_GETARG_INTERVAL_P(0));
+
+	return DirectFunctionCall1(hashint8, Int64GetDatumFast(key));
+}
+
+Datum
+duration_hash_interval_extended(PG_FUNCTION_ARGS)
+{
+	int64		key = interval_hash_key(PG_GETARG_INTERVAL_P(0));
+
+	return DirectFunctionCall2(hashint8extended, Int64GetDatumFast(key),
+							   PG_GETARG_DATUM(1));
+}
+
+/*****************************************************************************
+ *				   Integer arithmetic
+ *****************************************************************************/
+
+/*
+ * These operators work on the microsecond count directly.  Unlike the float8
+ * operators they are exact for every duration, not just those below 2^53
+ * microseconds, and they never round-trip through a double.
+ */
+
+static Duration
+duration_mul_int8_internal(Duration duration, int64 factor)
+{
+	Duration	result;
+
+	/*
+	 * As with the float8 variant, "infinity * 0" is an error since the
+	 * duration type has nothing equivalent to NaN.
+	 */
+	if (DURATION_NOT_FINITE(duration))
+	{
+		if (factor == 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+					 errmsg("duration out of range")));
+
+		return factor < 0 ? duration_um_internal(duration) : duration;
+	}
+
+	if (pg_mul_s64_overflow(duration, factor, &result) ||
+		DURATION_NOT_FINITE(result))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
+
+	return result;
+}
+
+Datum
+duration_mul_int8(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_DURATION(duration_mul_int8_internal(PG_GETARG_DURATION(0),
+												  PG_GETARG_INT64(1)));
+}
+
+Datum
+int8_mul_duration(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_DURATION(duration_mul_int8_internal(PG_GETARG_DURATION(1),
+												  PG_GETARG_INT64(0)));
+}
+
+/*
+ * duration_div_int8 - divide a duration by a bigint
+ *
+ * The quotient is rounded to the nearest microsecond, ties to even, so the
+ * result is the same as the float8 operator gives whenever that one is exact.
+ */
+Datum
+duration_div_int8(PG_FUNCTION_ARGS)
+{
+	Duration	duration = PG_GETARG_DURATION(0);
+	int64		divisor = PG_GETARG_INT64(1);
+	Duration	result;
+	int64		rem;
+	uint64		absrem;
+	uint64		absdivisor;
+
+	if (divisor == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_DIVISION_BY_ZERO),
+				 errmsg("division by zero")));
+
+	if (DURATION_NOT_FINITE(duration))
+	{
+		if (divisor < 0)
+			result = duration_um_internal(duration);
+		else
+			result = duration;
+
+		PG_RETURN_DURATION(result);
+	}
+
+	/*
+	 * The dividend is finite, so it is never PG_INT64_MIN and neither the
+	 * division nor the rounding step below can overflow.
+	 */
+	result = duration / divisor;
+	rem = duration % divisor;
+
+	absrem = rem < 0 ? -(uint64) rem : (uint64) rem;
+	absdivisor = divisor < 0 ? -(uint64) divisor : (uint64) divisor;
+
+	if (absrem > absdivisor - absrem ||
+		(absrem == absdivisor - absrem && (result & 1) != 0))
+	{
+		if ((duration < 0) != (divisor < 0))
+			result--;
+		else
+			result++;
+	}
+
+	PG_RETURN_DURATION(result);
+}
+
+/*
+ * duration_div_duration - ratio of two durations
+ *
+ * Infinite operands behave as float8 infinities would, so dividing one
+ * infinite duration by another gives NaN.
+ */
+Datum
+duration_div_duration(PG_FUNCTION_ARGS)
+{
+	Duration	duration1 = PG_GETARG_DURATION(0);
+	Duration	duration2 = PG_GETARG_DURATION(1);
+
+	if (duration2 == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_DIVISION_BY_ZERO),
+				 errmsg("division by zero")));
+
+	if (DURATION_NOT_FINITE(duration1) || DURATION_NOT_FINITE(duration2))
+	{
+		float8		f1 = duration1;
+		float8		f2 = duration2;
+
+		if (DURATION_IS_NOBEGIN(duration1))
+			f1 = -get_float8_infinity();
+		else if (DURATION_IS_NOEND(duration1))
+			f1 = get_float8_infinity();
+
+		if (DURATION_IS_NOBEGIN(duration2))
+			f2 = -get_float8_infinity();
+		else if (DURATION_IS_NOEND(duration2))
+			f2 = get_float8_infinity();
+
+		PG_RETURN_FLOAT8(f1 / f2);
+	}
+
+	/*
+	 * Split off the integral part first so that it is exact up to 2^53 and
+	 * only the fraction is subject to rounding.
+	 */
+	PG_RETURN_FLOAT8((float8) (duration1 / duration2) +
+					 (float8) (duration1 % duration2) / (float8) duration2);
+}
+
+/*
+ * duration_quotient - div(duration, duration), truncated toward zero like
+ * div(numeric, numeric)
+ */
+Datum
+duration_quotient(PG_FUNCTION_ARGS)
+{
+	Duration	duration1 = PG_GETARG_DURATION(0);
+	Duration	duration2 = PG_GETARG_DURATION(1);
+
+	if (duration2 == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_DIVISION_BY_ZERO),
+				 errmsg("division by zero")));
+
+	if (DURATION_NOT_FINITE(duration1))
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("bigint out of range")));
+
+	if (DURATION_NOT_FINITE(duration2))
+		PG_RETURN_INT64(0);
+
+	PG_RETURN_INT64(duration1 / duration2);
+}
+
+/*
+ * duration_mod - remainder of div(duration, duration), taking the sign of the
+ * dividend
+ */
+Datum
+duration_mod(PG_FUNCTION_ARGS)
+{
+	Duration	duration1 = PG_GETARG_DURATION(0);
+	Duration	duration2 = PG_GETARG_DURATION(1);
+
+	if (duration2 == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_DIVISION_BY_ZERO),
+				 errmsg("division by zero")));
+
+	if (DURATION_NOT_FINITE(duration1))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
+
+	if (DURATION_NOT_FINITE(duration2))
+		PG_RETURN_DURATION(duration1);
+
+	PG_RETURN_DURATION(duration1 % duration2);
+}
+
+/*****************************************************************************
+ *				   Statistics
+ *****************************************************************************/
+
+/*
+ * Shared totals of the hot-path counters.  Backends never touch these on the
+ * hot path itself; they add their local counts once per transaction, so the
+ * cost of tracking is a test and an increment of a backend-local variable.
+ */
+typedef struct DurationSharedStats
+{
+	slock_t		mutex;			/* protects stats_reset */
+	TimestampTz stats_reset;
+	pg_atomic_uint64 counters[DURATION_STATS_NUM_COUNTERS];
+} DurationSharedStats;
+
+static DurationSharedStats *duration_shared_stats = NULL;
+
+static shmem_request_hook_type prev_shmem_request_hook = NULL;
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+static void duration_stats_shmem_request(void);
+static void duration_stats_shmem_startup(void);
+static void duration_stats_xact_callback(XactEvent event, void *arg);
+
+void
+_PG_init(void)
+{
+	DefineCustomBoolVariable("pg_duration.track_stats",
+							 "Counts duration parsing paths, overflows, aggregate states and interval casts.",
+							 "The counts are reported by the pg_duration_stats view.",
+							 &duration_track_stats,
+							 false,
+							 PGC_SUSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	MarkGUCPrefixReserved("pg_duration");
+
+	/*
+	 * Without shared_preload_libraries there is no shared memory to add to,
+	 * and pg_duration_stats reports only the current backend's counts.
+	 */
+	if (!process_shared_preload_libraries_in_progress)
+		return;
+
+	prev_shmem_request_hook = shmem_request_hook;
+	shmem_request_hook = duration_stats_shmem_request;
+	prev_shmem_startup_hook = shmem_startup_hook;
+	shmem_startup_hook = duration_stats_shmem_startup;
+
+	RegisterXactCallback(duration_stats_xact_callback, NULL);
+}
+
+static void
+duration_stats_shmem_request(void)
+{
+	if (prev_shmem_request_hook)
+		prev_shmem_request_hook();
+
+	RequestAddinShmemSpace(MAXALIGN(sizeof(DurationSharedStats)));
+}
+
+static void
+duration_stats_shmem_startup(void)
+{
+	bool		found;
+
+	if (prev_shmem_startup_hook)
+		prev_shmem_startup_hook();
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	duration_shared_stats = ShmemInitStruct("pg_duration stats",
+											sizeof(DurationSharedStats),
+											&found);
+	if (!found)
+	{
+		SpinLockInit(&duration_shared_stats->mutex);
+		duration_shared_stats->stats_reset = GetCurrentTimestamp();
+		for (int i = 0; i < DURATION_STATS_NUM_COUNTERS; i++)
+			pg_atomic_init_u64(&duration_shared_stats->counters[i], 0);
+	}
+
+	LWLockRelease(AddinShmemInitLock);
+}
+
+/*
+ * Add the backend's counts to the shared totals and start over.
+ */
+static void
+duration_stats_flush(void)
+{
+	if (duration_shared_stats == NULL)
+		return;
+
+	for (int i = 0; i < DURATION_STATS_NUM_COUNTERS; i++)
+	{
+		if (duration_local_stats[i] != 0)
+		{
+			pg_atomic_fetch_add_u64(&duration_shared_stats->counters[i],
+									(int64) duration_local_stats[i]);
+			duration_local_stats[i] = 0;
+		}
+	}
+}
+
+static void
+duration_stats_xact_callback(XactEvent event, void *arg)
+{
+	switch (event)
+	{
+		case XACT_EVENT_COMMIT:
+		case XACT_EVENT_PARALLEL_COMMIT:
+		case XACT_EVENT_ABORT:
+		case XACT_EVENT_PARALLEL_ABORT:
+			duration_stats_flush();
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * pg_duration_stats - the shared totals plus the current backend's counts
+ * not yet added to them
+ */
+Datum
+pg_duration_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[DURATION_STATS_NUM_COUNTERS + 1];
+	bool		nulls[DURATION_STATS_NUM_COUNTERS + 1] = {0};
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	for (int i = 0; i < DURATION_STATS_NUM_COUNTERS; i++)
+	{
+		uint64		count = duration_local_stats[i];
+
+		if (duration_shared_stats != NULL)
+			count += pg_atomic_read_u64(&duration_shared_stats->counters[i]);
+
+		values[i] = Int64GetDatum((int64) count);
+	}
+
+	if (duration_shared_stats != NULL)
+	{
+		TimestampTz stats_reset;
+
+		SpinLockAcquire(&duration_shared_stats->mutex);
+		stats_reset = duration_shared_stats->stats_reset;
+		SpinLockRelease(&duration_shared_stats->mutex);
+
+		values[DURATION_STATS_NUM_COUNTERS] = TimestampTzGetDatum(stats_reset);
+	}
+	else
+		nulls[DURATION_STATS_NUM_COUNTERS] = true;
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+Datum
+pg_duration_stats_reset(PG_FUNCTION_ARGS)
+{
+	memset(duration_local_stats, 0, sizeof(duration_local_stats));
+
+	if (duration_shared_stats != NULL)
+	{
+		for (int i = 0; i < DURATION_STATS_NUM_COUNTERS; i++)
+			pg_atomic_write_u64(&duration_shared_stats->counters[i], 0);
+
+		SpinLockAcquire(&duration_shared_stats->mutex);
+		duration_shared_stats->stats_reset = GetCurrentTimestamp();
+		SpinLockRelease(&duration_shared_stats->mutex);
+	}
+
+	PG_RETURN_VOID();
+}
+
+/*****************************************************************************
+ *				   Compressed series
+ *****************************************************************************/
+
+/*
+ * A duration_series stores a sequence of durations in blocks of up to
+ * DURATION_SERIES_BLOCK values.  Each block is frame-of-reference encoded:
+ * its smallest value is stored in full, followed by the bit width needed for
+ * the largest offset from it and then every value's offset, packed
+ * least-significant bit first.  Latency samples that cluster within a few
+ * milliseconds of each other take two or three bytes each rather than eight
+ * plus a tuple header.
+ *
+ * The count and the extremes of the whole series are kept in the header, so
+ * count, min and max are read without decoding anything, and the rest is
+ * decoded one block at a time.
+ */
+#define DURATION_SERIES_BLOCK	128
+
+typedef struct DurationSeries
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	int32		count;			/* number of values */
+	Duration	min;			/* smallest value, if count > 0 */
+	Duration	max;			/* largest value, if count > 0 */
+	/* the blocks, each an 8-byte reference, a 1-byte width and the offsets */
+	uint8		data[FLEXIBLE_ARRAY_MEMBER];
+} DurationSeries;
+
+#define DURATION_SERIES_BLOCK_HEADER	(sizeof(Duration) + 1)
+
+#define DatumGetDurationSeriesP(X)	((DurationSeries *) PG_DETOAST_DATUM(X))
+#define PG_GETARG_DURATION_SERIES_P(n)	DatumGetDurationSeriesP(PG_GETARG_DATUM(n))
+/* Just the header, which spares decompressing the blocks */
+#define PG_GETARG_DURATION_SERIES_HEADER_P(n) \
+	((DurationSeries *) PG_DETOAST_DATUM_SLICE(PG_GETARG_DATUM(n), 0, \
+											   offsetof(DurationSeries, data) - VARHDRSZ))
+#define PG_RETURN_DURATION_SERIES_P(x)	PG_RETURN_POINTER(x)
+
+/*
+ * The transition state of duration_series_agg(): the values in input order.
+ */
+typedef struct DurationSeriesState
+{
+	int32		count;			/* number of values */
+	int32		capacity;		/* allocated length of values */
+	Duration   *values;
+} DurationSeriesState;
+
+#define DURATION_SERIES_MAX_COUNT	((int32) (MaxAllocSize / sizeof(Duration)))
+
+/* Number of bits needed for offsets from min up to max */
+static inline int
+duration_series_width(Duration min, Duration max)
+{
+	uint64		range = (uint64) max - (uint64) min;
+
+	return range == 0 ? 0 : pg_leftmost_one_pos64(range) + 1;
+}
+
+static inline Size
+duration_series_block_size(int32 n, int width)
+{
+	return DURATION_SERIES_BLOCK_HEADER + ((Size) n * width + 7) / 8;
+}
+
+static void
+duration_series_range(const Duration *values, int32 n,
+					  Duration *min, Duration *max)
+{
+	*min = *max = values[0];
+	for (int32 i = 1; i < n; i++)
+	{
+		if (values[i] < *min)
+			*min = values[i];
+		else if (values[i] > *max)
+			*max = values[i];
+	}
+}
+
+/* OR the low width bits of value into buf at bit position pos */
+static inline void
+duration_series_put_bits(uint8 *buf, uint64 pos, int width, uint64 value)
+{
+	uint8	   *b = buf + pos / 8;
+	int			shift = pos % 8;
+	int			done = 8 - shift;
 
-	if (type == UNITS)
+	*b++ |= (uint8) (value << shift);
+	while (done < width)
 	{
-		duration2itm(duration, tm);
-		switch (val)
-		{
-			case DTK_MICROSEC:
-				intresult = tm->tm_sec * INT64CONST(1000000) + tm->tm_usec;
-				break;
+		*b++ |= (uint8) (value >> done);
+		done += 8;
+	}
+}
 
-			case DTK_MILLISEC:
-				if (retnumeric)
-					/*---
-					 * tm->tm_sec * 1000 + fsec / 1000
-					 * = (tm->tm_sec * 1'000'000 + fsec) / 1000
-					 */
-					PG_RETURN_NUMERIC(int64_div_fast_to_numeric(tm->tm_sec * INT64CONST(1000000) + tm->tm_usec, 3));
-				else
-					PG_RETURN_FLOAT8(tm->tm_sec * 1000.0 + tm->tm_usec / 1000.0);
-				break;
+/* Read width (1 to 64) bits from buf at bit position pos */
+static inline uint64
+duration_series_get_bits(const uint8 *buf, uint64 pos, int width)
+{
+	const uint8 *b = buf + pos / 8;
+	int			shift = pos % 8;
+	int			got = 8 - shift;
+	uint64		value = *b++ >> shift;
 
-			case DTK_SECOND:
-				if (retnumeric)
-					/*---
-					 * tm->tm_sec + fsec / 1'000'000
-					 * = (tm->tm_sec * 1'000'000 + fsec) / 1'000'000
-					 */
-					PG_RETURN_NUMERIC(int64_div_fast_to_numeric(tm->tm_sec * INT64CONST(1000000) + tm->tm_usec, 6));
-				else
-					PG_RETURN_FLOAT8(tm->tm_sec + tm->tm_usec / 1000000.0);
-				break;
+	while (got < width)
+	{
+		value |= (uint64) *b++ << got;
+		got += 8;
+	}
 
-			case DTK_MINUTE:
-				intresult = tm->tm_min;
-				break;
+	return width == 64 ? value : value & ((UINT64CONST(1) << width) - 1);
+}
 
-			case DTK_HOUR:
-				intresult = tm->tm_hour;
-				break;
+static DurationSeries *
+duration_series_encode(const Duration *values, int32 count)
+{
+	DurationSeries *series;
+	Size		size = offsetof(DurationSeries, data);
+	uint8	   *p;
 
-			default:
-				ereport(ERROR,
-						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-						 errmsg("unit \"%s\" not supported for type duration",
-								lowunits)));
-				intresult = 0;
-		}
+	for (int32 start = 0; start < count; start += DURATION_SERIES_BLOCK)
+	{
+		int32		n = Min(DURATION_SERIES_BLOCK, count - start);
+		Duration	min;
+		Duration	max;
+
+		duration_series_range(values + start, n, &min, &max);
+		size += duration_series_block_size(n, duration_series_width(min, max));
 	}
-	else if (type == RESERV && val == DTK_EPOCH)
+
+	if (size > MaxAllocSize)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("duration series is too large")));
+
+	series = (DurationSeries *) palloc0(size);
+	SET_VARSIZE(series, size);
+	series->count = count;
+	if (count > 0)
+		duration_series_range(values, count, &series->min, &series->max);
+
+	p = series->data;
+	for (int32 start = 0; start < count; start += DURATION_SERIES_BLOCK)
 	{
-		if (retnumeric)
-		{
-			Numeric		result;
+		int32		n = Min(DURATION_SERIES_BLOCK, count - start);
+		Duration	min;
+		Duration	max;
+		int			width;
 
-			result = int64_div_fast_to_numeric(duration, 6);
+		duration_series_range(values + start, n, &min, &max);
+		width = duration_series_width(min, max);
 
-			PG_RETURN_NUMERIC(result);
-		}
-		else
+		memcpy(p, &min, sizeof(Duration));
+		p[sizeof(Duration)] = (uint8) width;
+		if (width > 0)
 		{
-			float8		result;
-
-			result = duration / 1000000.0;
+			uint8	   *bits = p + DURATION_SERIES_BLOCK_HEADER;
 
-			PG_RETURN_FLOAT8(result);
+			for (int32 i = 0; i < n; i++)
+				duration_series_put_bits(bits, (uint64) i * width, width,
+										 (uint64) values[start + i] - (uint64) min);
 		}
+		p += duration_series_block_size(n, width);
+	}
+
+	return series;
+}
+
+/*
+ * Iteration over the blocks of a series.  Each call of
+ * duration_series_next_block() decodes the next block into values and
+ * returns how many it holds, or 0 at the end.
+ */
+typedef struct DurationSeriesIter
+{
+	const DurationSeries *series;
+	const uint8 *next;			/* start of the next block */
+	int32		remaining;		/* values in the blocks not yet decoded */
+} DurationSeriesIter;
+
+static void
+duration_series_iter_init(DurationSeriesIter *iter, const DurationSeries *series)
+{
+	iter->series = series;
+	iter->next = series->data;
+	iter->remaining = series->count;
+}
+
+static int32
+duration_series_next_block(DurationSeriesIter *iter, Duration *values)
+{
+	const uint8 *end = (const uint8 *) iter->series + VARSIZE(iter->series);
+	const uint8 *bits;
+	int32		n = Min(DURATION_SERIES_BLOCK, iter->remaining);
+	Duration	ref;
+	int			width;
+
+	if (n <= 0)
+		return 0;
+
+	if (end - iter->next < (ptrdiff_t) DURATION_SERIES_BLOCK_HEADER)
+		elog(ERROR, "invalid duration series");
+	memcpy(&ref, iter->next, sizeof(Duration));
+	width = iter->next[sizeof(Duration)];
+	if (width > 64 ||
+		end - iter->next < (ptrdiff_t) duration_series_block_size(n, width))
+		elog(ERROR, "invalid duration series");
+
+	bits = iter->next + DURATION_SERIES_BLOCK_HEADER;
+	if (width == 0)
+	{
+		for (int32 i = 0; i < n; i++)
+			values[i] = ref;
 	}
 	else
 	{
-		ereport(ERROR,
-				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-				 errmsg("unit \"%s\" not recognized for type duration",
-						lowunits)));
-		intresult = 0;
+		for (int32 i = 0; i < n; i++)
+			values[i] = (Duration) ((uint64) ref +
+									duration_series_get_bits(bits, (uint64) i * width, width));
 	}
 
-	if (retnumeric)
-		PG_RETURN_NUMERIC(int64_to_numeric(intresult));
-	else
-		PG_RETURN_FLOAT8(intresult);
+	iter->next += duration_series_block_size(n, width);
+	iter->remaining -= n;
+
+	return n;
 }
 
+/*
+ * Text representation is a brace-enclosed, comma-separated list of
+ * durations in the current IntervalStyle, like an array's.
+ */
 Datum
-duration_part(PG_FUNCTION_ARGS)
+duration_series_in(PG_FUNCTION_ARGS)
 {
-	return duration_part_common(fcinfo, false);
+	char	   *str = PG_GETARG_CSTRING(0);
+	struct Node *escontext = fcinfo->context;
+	char	   *cp = str;
+	char	   *copy;
+	Duration   *values;
+	int32		count = 0;
+	int32		capacity = 64;
+
+	while (isspace((unsigned char) *cp))
+		cp++;
+	if (*cp++ != '{')
+		goto syntax_error;
+	while (isspace((unsigned char) *cp))
+		cp++;
+
+	values = (Duration *) palloc(capacity * sizeof(Duration));
+	copy = pstrdup(cp);
+	cp = copy;
+
+	if (*cp == '}')
+		cp++;
+	else
+	{
+		for (;;)
+		{
+			char	   *elem = cp;
+			char		delim;
+			Datum		value;
+
+			while (*cp != ',' && *cp != '}' && *cp != '\0')
+				cp++;
+			if (*cp == '\0')
+				goto syntax_error;
+			delim = *cp;
+			*cp++ = '\0';
+
+			if (count == capacity)
+			{
+				if (capacity >= DURATION_SERIES_MAX_COUNT / 2)
+					ereturn(escontext, (Datum) 0,
+							(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+							 errmsg("duration series is too large")));
+				capacity *= 2;
+				values = (Duration *) repalloc(values, capacity * sizeof(Duration));
+			}
+
+			if (!DirectInputFunctionCallSafe(duration_in, elem, InvalidOid, -1,
+											 escontext, &value))
+				PG_RETURN_NULL();
+			values[count++] = DatumGetDuration(value);
+
+			if (delim == '}')
+				break;
+		}
+	}
+
+	/* nothing may follow except whitespace */
+	while (isspace((unsigned char) *cp))
+		cp++;
+	if (*cp != '\0')
+		goto syntax_error;
+
+	PG_RETURN_DURATION_SERIES_P(duration_series_encode(values, count));
+
+syntax_error:
+	ereturn(escontext, (Datum) 0,
+			(errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+			 errmsg("invalid input syntax for type %s: \"%s\"",
+					"duration_series", str)));
 }
 
 Datum
-extract_duration(PG_FUNCTION_ARGS)
+duration_series_out(PG_FUNCTION_ARGS)
 {
-	return duration_part_common(fcinfo, true);
+	DurationSeries *series = PG_GETARG_DURATION_SERIES_P(0);
+	DurationSeriesIter iter;
+	Duration	values[DURATION_SERIES_BLOCK];
+	StringInfoData buf;
+	int32		n;
+	bool		first = true;
+
+	initStringInfo(&buf);
+	appendStringInfoChar(&buf, '{');
+
+	duration_series_iter_init(&iter, series);
+	while ((n = duration_series_next_block(&iter, values)) > 0)
+	{
+		for (int32 i = 0; i < n; i++)
+		{
+			if (!first)
+				appendStringInfoChar(&buf, ',');
+			appendStringInfoString(&buf,
+								   DatumGetCString(DirectFunctionCall1(duration_out,
+																	   DurationGetDatum(values[i]))));
+			first = false;
+		}
+	}
+
+	appendStringInfoChar(&buf, '}');
+
+	PG_RETURN_CSTRING(buf.data);
 }
 
-/*****************************************************************************
- *				   Casts
- *****************************************************************************/
+/*
+ * The binary representation is the count followed by every value, leaving
+ * the encoding free to change.
+ */
+Datum
+duration_series_recv(PG_FUNCTION_ARGS)
+{
+	StringInfo	buf = (StringInfo) PG_GETARG_POINTER(0);
+	int32		count = pq_getmsgint(buf, 4);
+	Duration   *values;
+
+	if (count < 0 || (int64) count * sizeof(Duration) > buf->len - buf->cursor)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid duration series count")));
+
+	values = (Duration *) palloc(Max(count, 1) * sizeof(Duration));
+	for (int32 i = 0; i < count; i++)
+		values[i] = pq_getmsgint64(buf);
+
+	PG_RETURN_DURATION_SERIES_P(duration_series_encode(values, count));
+}
 
 Datum
-duration_interval(PG_FUNCTION_ARGS)
+duration_series_send(PG_FUNCTION_ARGS)
 {
-	Duration	duration = PG_GETARG_DURATION(0);
-	Interval   *result;
+	DurationSeries *series = PG_GETARG_DURATION_SERIES_P(0);
+	DurationSeriesIter iter;
+	Duration	values[DURATION_SERIES_BLOCK];
+	StringInfoData buf;
+	int32		n;
 
-	result = (Interval *) palloc(sizeof(Interval));
+	pq_begintypsend(&buf);
+	pq_sendint32(&buf, series->count);
 
-	if (DURATION_IS_NOBEGIN(duration))
+	duration_series_iter_init(&iter, series);
+	while ((n = duration_series_next_block(&iter, values)) > 0)
 	{
-		INTERVAL_NOBEGIN(result);
+		for (int32 i = 0; i < n; i++)
+			pq_sendint64(&buf, values[i]);
 	}
-	else if (DURATION_IS_NOEND(duration))
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/*
+ * Transition function for duration_series_agg(duration).  Values are kept
+ * in input order; null inputs are skipped.
+ */
+Datum
+duration_series_accum(PG_FUNCTION_ARGS)
+{
+	DurationSeriesState *state;
+	MemoryContext agg_context;
+	MemoryContext old_context;
+
+	if (!AggCheckCallContext(fcinfo, &agg_context))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state = PG_ARGISNULL(0) ? NULL : (DurationSeriesState *) PG_GETARG_POINTER(0);
+
+	if (PG_ARGISNULL(1))
+		PG_RETURN_POINTER(state);
+
+	old_context = MemoryContextSwitchTo(agg_context);
+
+	/* Create the state data on the first call */
+	if (state == NULL)
 	{
-		INTERVAL_NOEND(result);
+		state = (DurationSeriesState *) palloc(sizeof(DurationSeriesState));
+		state->count = 0;
+		state->capacity = DURATION_SERIES_BLOCK;
+		state->values = (Duration *) palloc(state->capacity * sizeof(Duration));
 	}
-	else
+	else if (state->count == state->capacity)
 	{
-		result->time = duration;
-		result->day = 0;
-		result->month = 0;
+		if (state->capacity >= DURATION_SERIES_MAX_COUNT / 2)
+			ereport(ERROR,
+					(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+					 errmsg("duration series is too large")));
+		state->capacity *= 2;
+		state->values = (Duration *) repalloc(state->values,
+											  state->capacity * sizeof(Duration));
 	}
 
-	PG_RETURN_INTERVAL_P(result);
+	state->values[state->count++] = PG_GETARG_DURATION(1);
+
+	MemoryContextSwitchTo(old_context);
+
+	PG_RETURN_POINTER(state);
 }
 
 Datum
-interval_duration(PG_FUNCTION_ARGS)
+duration_series_final(PG_FUNCTION_ARGS)
 {
-	Interval   *interval = PG_GETARG_INTERVAL_P(0);
-	struct Node *escontext = fcinfo->context;
-	Duration	result;
+	DurationSeriesState *state;
 
-	if (INTERVAL_IS_NOBEGIN(interval))
+	state = PG_ARGISNULL(0) ? NULL : (DurationSeriesState *) PG_GETARG_POINTER(0);
+
+	/* If there were no non-null inputs, return NULL */
+	if (state == NULL)
+		PG_RETURN_NULL();
+
+	PG_RETURN_DURATION_SERIES_P(duration_series_encode(state->values,
+													   state->count));
+}
+
+/*
+ * unnest(duration_series) - the values in order, decoding one block at a
+ * time
+ */
+typedef struct
+{
+	DurationSeriesIter iter;
+	int32		n;				/* number of values in the current block */
+	int32		pos;			/* next value to return from it */
+	Duration	values[DURATION_SERIES_BLOCK];
+} duration_series_unnest_fctx;
+
+Datum
+duration_series_unnest(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	duration_series_unnest_fctx *fctx;
+
+	/* stuff done only on the first call of the function */
+	if (SRF_IS_FIRSTCALL())
 	{
-		DURATION_NOBEGIN(result);
+		MemoryContext oldcontext;
+
+		/* create a function context for cross-call persistence */
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		/*
+		 * switch to memory context appropriate for multiple function calls,
+		 * so that the detoasted series lives as long as the scan
+		 */
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		fctx = (duration_series_unnest_fctx *)
+			palloc(sizeof(duration_series_unnest_fctx));
+		duration_series_iter_init(&fctx->iter, PG_GETARG_DURATION_SERIES_P(0));
+		fctx->n = 0;
+		fctx->pos = 0;
+
+		funcctx->user_fctx = fctx;
+		MemoryContextSwitchTo(oldcontext);
 	}
-	else if (INTERVAL_IS_NOEND(interval))
+
+	/* stuff done on every call of the function */
+	funcctx = SRF_PERCALL_SETUP();
+	fctx = funcctx->user_fctx;
+
+	if (fctx->pos == fctx->n)
 	{
-		DURATION_NOEND(result);
+		fctx->n = duration_series_next_block(&fctx->iter, fctx->values);
+		fctx->pos = 0;
+		if (fctx->n == 0)
+			SRF_RETURN_DONE(funcctx);
 	}
-	else if (interval->month != 0 || interval->day != 0)
-	{
-		ereturn(escontext, (Datum) 0,
+
+	SRF_RETURN_NEXT(funcctx, DurationGetDatum(fctx->values[fctx->pos++]));
+}
+
+Datum
+duration_series_count(PG_FUNCTION_ARGS)
+{
+	DurationSeries *series = PG_GETARG_DURATION_SERIES_HEADER_P(0);
+
+	PG_RETURN_INT64(series->count);
+}
+
+/*
+ * series_sum(duration_series) - like sum(duration) over the values, including
+ * its treatment of infinities, which the header's extremes reveal without
+ * decoding.  An empty series has a null sum.
+ */
+Datum
+duration_series_sum(PG_FUNCTION_ARGS)
+{
+	DurationSeries *series = PG_GETARG_DURATION_SERIES_P(0);
+	DurationSeriesIter iter;
+	Duration	values[DURATION_SERIES_BLOCK];
+	DurationSum sum = 0;
+	Duration	result;
+	int32		n;
+
+	if (series->count == 0)
+		PG_RETURN_NULL();
+
+	if (DURATION_IS_NOBEGIN(series->min) && DURATION_IS_NOEND(series->max))
+		ereport(ERROR,
 				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
-				 errmsg("invalid units for duration")));
-	}
+				 errmsg("duration out of range")));
+
+	if (DURATION_IS_NOEND(series->max))
+		DURATION_NOEND(result);
+	else if (DURATION_IS_NOBEGIN(series->min))
+		DURATION_NOBEGIN(result);
 	else
 	{
-		result = interval->time;
+		duration_series_iter_init(&iter, series);
+		while ((n = duration_series_next_block(&iter, values)) > 0)
+		{
+			for (int32 i = 0; i < n; i++)
+				duration_sum_add(&sum, values[i]);
+		}
+		result = duration_sum_result(sum);
 	}
 
 	PG_RETURN_DURATION(result);
 }
 
-/*****************************************************************************
- *				   Aggregates
- *****************************************************************************/
-
-/*
- * Prepare state data for a duration aggregate function, that needs to compute
- * sum and count, in the aggregate's memory context.
- *
- * The function is used when the state data needs to be allocated in aggregate's
- * context. When the state data needs to be allocated in the current memory
- * context, we use palloc0 directly e.g. duration_avg_deserialize().
- */
-static DurationAggState *
-makeDurationAggState(FunctionCallInfo fcinfo)
+Datum
+duration_series_min(PG_FUNCTION_ARGS)
 {
-	DurationAggState *state;
-	MemoryContext agg_context;
-	MemoryContext old_context;
+	DurationSeries *series = PG_GETARG_DURATION_SERIES_HEADER_P(0);
 
-	if (!AggCheckCallContext(fcinfo, &agg_context))
-		elog(ERROR, "aggregate function called in non-aggregate context");
+	if (series->count == 0)
+		PG_RETURN_NULL();
 
-	old_context = MemoryContextSwitchTo(agg_context);
+	PG_RETURN_DURATION(series->min);
+}
 
-	state = (DurationAggState *) palloc0(sizeof(DurationAggState));
+Datum
+duration_series_max(PG_FUNCTION_ARGS)
+{
+	DurationSeries *series = PG_GETARG_DURATION_SERIES_HEADER_P(0);
 
-	MemoryContextSwitchTo(old_context);
+	if (series->count == 0)
+		PG_RETURN_NULL();
 
-	return state;
+	PG_RETURN_DURATION(series->max);
 }
 
+/*****************************************************************************
+ *				   Array functions
+ *****************************************************************************/
+
 /*
- * Accumulate a new input value for duration aggregate functions.
+ * Get the non-null elements of a duration array as a plain vector.  Nulls
+ * take no space in an array's data area, and duration elements are int64s
+ * aligned on doubles, so without nulls the data area is that vector already
+ * and is returned in place.  Otherwise the elements are copied out.
  */
-static void
-do_duration_accum(DurationAggState *state, Duration newval)
+static Duration *
+duration_array_values(ArrayType *array, int *nvalues)
 {
-	/* Infinite inputs are counted separately, and do not affect "N" */
-	if (DURATION_IS_NOBEGIN(newval))
+	int			nitems = ArrayGetNItems(ARR_NDIM(array), ARR_DIMS(array));
+	Duration   *data = (Duration *) ARR_DATA_PTR(array);
+	bits8	   *bitmap = ARR_NULLBITMAP(array);
+	Duration   *values;
+	int			n = 0;
+
+	if (bitmap == NULL)
 	{
-		state->nInfcount++;
-		return;
+		*nvalues = nitems;
+		return data;
 	}
 
-	if (DURATION_IS_NOEND(newval))
+	values = (Duration *) palloc(Max(nitems, 1) * sizeof(Duration));
+	for (int i = 0; i < nitems; i++)
 	{
-		state->pInfcount++;
-		return;
+		if (bitmap[i / 8] & (1 << (i % 8)))
+		{
+			values[n] = data[n];
+			n++;
+		}
 	}
 
-	state->sumX = finite_duration_pl(state->sumX, newval);
-	state->N++;
+	*nvalues = n;
+	return values;
 }
 
 /*
- * Remove the given duration value from the aggregated state.
+ * Smallest and largest of a nonempty vector of durations.  Infinities are
+ * ordered correctly by plain int64 comparison.  Four independent running
+ * extremes keep the loop free of a serial dependency, so that several
+ * comparisons can be in flight at once.
  */
 static void
-do_duration_discard(DurationAggState *state, Duration newval)
+duration_array_extremes_scalar(const Duration *values, int n,
+							   Duration *min, Duration *max)
 {
-	/* Infinite inputs are counted separately, and do not affect "N" */
-	if (DURATION_IS_NOBEGIN(newval))
-	{
-		state->nInfcount--;
-		return;
-	}
+	Duration	lo[4];
+	Duration	hi[4];
+	int			i = 0;
 
-	if (DURATION_IS_NOEND(newval))
+	Assert(n > 0);
+
+	for (int j = 0; j < 4; j++)
+		lo[j] = hi[j] = values[0];
+
+	for (; i + 4 <= n; i += 4)
 	{
-		state->pInfcount--;
-		return;
+		for (int j = 0; j < 4; j++)
+		{
+			lo[j] = Min(lo[j], values[i + j]);
+			hi[j] = Max(hi[j], values[i + j]);
+		}
 	}
-
-	/* Handle the to-be-discarded finite value. */
-	state->N--;
-	if (state->N > 0)
-		state->sumX = finite_duration_mi(state->sumX, newval);
-	else
+	for (; i < n; i++)
 	{
-		/* All values discarded, reset the state */
-		Assert(state->N == 0);
-		memset(&state->sumX, 0, sizeof(state->sumX));
+		lo[0] = Min(lo[0], values[i]);
+		hi[0] = Max(hi[0], values[i]);
 	}
+
+	*min = Min(Min(lo[0], lo[1]), Min(lo[2], lo[3]));
+	*max = Max(Max(hi[0], hi[1]), Max(hi[2], hi[3]));
 }
 
 /*
- * Transition function for sum() and avg() duration aggregates.
+ * Sum of a vector of finite durations, in four independent accumulators for
+ * the same reason as above.
  */
-Datum
-duration_avg_accum(PG_FUNCTION_ARGS)
+static DurationSum
+duration_array_total_scalar(const Duration *values, int n)
 {
-	DurationAggState *state;
+	DurationSum sums[4] = {0};
+	int			i = 0;
 
-	state = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
-
-	/* Create the state data on the first call */
-	if (state == NULL)
-		state = makeDurationAggState(fcinfo);
+	for (; i + 4 <= n; i += 4)
+	{
+		for (int j = 0; j < 4; j++)
+			duration_sum_add(&sums[j], values[i + j]);
+	}
+	for (; i < n; i++)
+		duration_sum_add(&sums[0], values[i]);
 
-	if (!PG_ARGISNULL(1))
-		do_duration_accum(state, PG_GETARG_DURATION(1));
+	duration_sum_combine_internal(&sums[0], sums[1]);
+	duration_sum_combine_internal(&sums[2], sums[3]);
+	duration_sum_combine_internal(&sums[0], sums[2]);
 
-	PG_RETURN_POINTER(state);
+	return sums[0];
 }
 
+#ifdef USE_AVX2_ARRAY_REDUCTIONS
+
 /*
- * Combine function for sum() and avg() duration aggregates.
- *
- * Combine the given internal aggregate states and place the combination in
- * the first argument.
+ * duration_array_extremes_scalar with four lanes of AVX2 signed 64-bit
+ * comparisons.
  */
-Datum
-duration_avg_combine(PG_FUNCTION_ARGS)
+pg_attribute_target("avx2")
+static void
+duration_array_extremes_avx2(const Duration *values, int n,
+							 Duration *min, Duration *max)
 {
-	DurationAggState *state1;
-	DurationAggState *state2;
-
-	state1 = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
-	state2 = PG_ARGISNULL(1) ? NULL : (DurationAggState *) PG_GETARG_POINTER(1);
+	__m256i		lo = _mm256_set1_epi64x(values[0]);
+	__m256i		hi = lo;
+	Duration	lo_lanes[4];
+	Duration	hi_lanes[4];
+	int			i = 0;
 
-	if (state2 == NULL)
-		PG_RETURN_POINTER(state1);
+	Assert(n > 0);
 
-	if (state1 == NULL)
+	for (; i + 4 <= n; i += 4)
 	{
-		/* manually copy all fields from state2 to state1 */
-		state1 = makeDurationAggState(fcinfo);
-
-		state1->N = state2->N;
-		state1->pInfcount = state2->pInfcount;
-		state1->nInfcount = state2->nInfcount;
-
-		state1->sumX = state2->sumX;
+		__m256i		v = _mm256_loadu_si256((const __m256i *) (values + i));
 
-		PG_RETURN_POINTER(state1);
+		lo = _mm256_blendv_epi8(lo, v, _mm256_cmpgt_epi64(lo, v));
+		hi = _mm256_blendv_epi8(hi, v, _mm256_cmpgt_epi64(v, hi));
 	}
 
-	state1->N += state2->N;
-	state1->pInfcount += state2->pInfcount;
-	state1->nInfcount += state2->nInfcount;
-
-	/* Accumulate finite duration values, if any. */
-	if (state2->N > 0)
-		state1->sumX = finite_duration_pl(state1->sumX, state2->sumX);
+	_mm256_storeu_si256((__m256i *) lo_lanes, lo);
+	_mm256_storeu_si256((__m256i *) hi_lanes, hi);
+	*min = Min(Min(lo_lanes[0], lo_lanes[1]), Min(lo_lanes[2], lo_lanes[3]));
+	*max = Max(Max(hi_lanes[0], hi_lanes[1]), Max(hi_lanes[2], hi_lanes[3]));
 
-	PG_RETURN_POINTER(state1);
+	for (; i < n; i++)
+	{
+		*min = Min(*min, values[i]);
+		*max = Max(*max, values[i]);
+	}
 }
 
+#ifdef HAVE_INT128
+
 /*
- * duration_avg_serialize
- *		Serialize DurationAggState for duration aggregates.
+ * duration_array_total_scalar in AVX2 lanes.  There is no 128-bit or
+ * overflow-checked lane arithmetic, so each value is split into its low and
+ * high 32 bits, taken as unsigned, and the lanes sum those halves and count
+ * the negative values; as an array has fewer than 2^30 elements none of them
+ * can overflow.  A value is then high * 2^32 + low, less 2^64 if negative.
  */
-Datum
-duration_avg_serialize(PG_FUNCTION_ARGS)
+pg_attribute_target("avx2")
+static DurationSum
+duration_array_total_avx2(const Duration *values, int n)
 {
-	DurationAggState *state;
-	StringInfoData buf;
-	bytea	   *result;
-
-	/* Ensure we disallow calling when not in aggregate context */
-	if (!AggCheckCallContext(fcinfo, NULL))
-		elog(ERROR, "aggregate function called in non-aggregate context");
-
-	state = (DurationAggState *) PG_GETARG_POINTER(0);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i low_mask = _mm256_set1_epi64x(0xFFFFFFFF);
+	__m256i		low = zero;
+	__m256i		high = zero;
+	__m256i		negative = zero;
+	uint64		low_lanes[4];
+	uint64		high_lanes[4];
+	uint64		negative_lanes[4];
+	DurationSum sum = 0;
+	int			i = 0;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256i		v = _mm256_loadu_si256((const __m256i *) (values + i));
 
-	pq_begintypsend(&buf);
+		low = _mm256_add_epi64(low, _mm256_and_si256(v, low_mask));
+		high = _mm256_add_epi64(high, _mm256_srli_epi64(v, 32));
+		/* the comparison is -1 in the lanes holding a negative value */
+		negative = _mm256_sub_epi64(negative, _mm256_cmpgt_epi64(zero, v));
+	}
 
-	/* N */
-	pq_sendint64(&buf, state->N);
+	_mm256_storeu_si256((__m256i *) low_lanes, low);
+	_mm256_storeu_si256((__m256i *) high_lanes, high);
+	_mm256_storeu_si256((__m256i *) negative_lanes, negative);
+	for (int j = 0; j < 4; j++)
+		sum += (int128) low_lanes[j] + ((int128) high_lanes[j] << 32) -
+			((int128) negative_lanes[j] << 64);
 
-	/* sumX */
-	pq_sendint64(&buf, state->sumX);
+	for (; i < n; i++)
+		sum += values[i];
 
-	/* pInfcount */
-	pq_sendint64(&buf, state->pInfcount);
+	return sum;
+}
 
-	/* nInfcount */
-	pq_sendint64(&buf, state->nInfcount);
+#endif							/* HAVE_INT128 */
 
-	result = pq_endtypsend(&buf);
+static void duration_array_extremes_choose(const Duration *values, int n,
+										   Duration *min, Duration *max);
+static DurationSum duration_array_total_choose(const Duration *values, int n);
 
-	PG_RETURN_BYTEA_P(result);
-}
+static void (*duration_array_extremes) (const Duration *values, int n,
+										Duration *min, Duration *max) = duration_array_extremes_choose;
+static DurationSum (*duration_array_total) (const Duration *values, int n) = duration_array_total_choose;
 
 /*
- * duration_avg_deserialize
- *		Deserialize bytea into DurationAggState for duration aggregates.
+ * On the first call, point the reductions at the AVX2 versions if the CPU
+ * and operating system support them, or else at the scalar ones.
  */
-Datum
-duration_avg_deserialize(PG_FUNCTION_ARGS)
+static void
+duration_array_reductions_choose(void)
 {
-	bytea	   *sstate;
-	DurationAggState *result;
-	StringInfoData buf;
-
-	if (!AggCheckCallContext(fcinfo, NULL))
-		elog(ERROR, "aggregate function called in non-aggregate context");
-
-	sstate = PG_GETARG_BYTEA_PP(0);
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		duration_array_extremes = duration_array_extremes_avx2;
+#ifdef HAVE_INT128
+		duration_array_total = duration_array_total_avx2;
+#else
+		duration_array_total = duration_array_total_scalar;
+#endif
+	}
+	else
+	{
+		duration_array_extremes = duration_array_extremes_scalar;
+		duration_array_total = duration_array_total_scalar;
+	}
+}
 
-	/*
-	 * Initialize a StringInfo so that we can "receive" it using the standard
-	 * recv-function infrastructure.
-	 */
-	initReadOnlyStringInfo(&buf, VARDATA_ANY(sstate),
-						   VARSIZE_ANY_EXHDR(sstate));
+static void
+duration_array_extremes_choose(const Duration *values, int n,
+							   Duration *min, Duration *max)
+{
+	duration_array_reductions_choose();
+	duration_array_extremes(values, n, min, max);
+}
 
-	result = (DurationAggState *) palloc0(sizeof(DurationAggState));
+static DurationSum
+duration_array_total_choose(const Duration *values, int n)
+{
+	duration_array_reductions_choose();
+	return duration_array_total(values, n);
+}
 
-	/* N */
-	result->N = pq_getmsgint64(&buf);
+#else							/* !USE_AVX2_ARRAY_REDUCTIONS */
 
-	/* sumX */
-	result->sumX = pq_getmsgint64(&buf);
+#define duration_array_extremes duration_array_extremes_scalar
+#define duration_array_total duration_array_total_scalar
 
-	/* pInfcount */
-	result->pInfcount = pq_getmsgint64(&buf);
+#endif							/* USE_AVX2_ARRAY_REDUCTIONS */
 
-	/* nInfcount */
-	result->nInfcount = pq_getmsgint64(&buf);
+/*
+ * Return the infinity that the sum or average of values with the given
+ * extremes is, or false if they are all finite.  Infinities with different
+ * signs are an error, as in sum() and avg().
+ */
+static bool
+duration_array_infinite(Duration min, Duration max, Duration *result)
+{
+	if (DURATION_IS_NOBEGIN(min) && DURATION_IS_NOEND(max))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+				 errmsg("duration out of range")));
 
-	pq_getmsgend(&buf);
+	if (DURATION_IS_NOEND(max))
+	{
+		DURATION_NOEND(*result);
+		return true;
+	}
+	if (DURATION_IS_NOBEGIN(min))
+	{
+		DURATION_NOBEGIN(*result);
+		return true;
+	}
 
-	PG_RETURN_POINTER(result);
+	return false;
 }
 
 /*
- * Inverse transition function for sum() and avg() duration aggregates.
+ * array_sum(duration[]) - like sum(duration) over the non-null elements.
+ * An array without any has a null sum.
  */
 Datum
-duration_avg_accum_inv(PG_FUNCTION_ARGS)
+duration_array_sum(PG_FUNCTION_ARGS)
 {
-	DurationAggState *state;
-
-	state = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
+	ArrayType  *array = PG_GETARG_ARRAYTYPE_P(0);
+	Duration   *values;
+	Duration	min;
+	Duration	max;
+	Duration	result;
+	int			n;
 
-	/* Should not get here with no state */
-	if (state == NULL)
-		elog(ERROR, "duration_avg_accum_inv called with NULL state");
+	values = duration_array_values(array, &n);
+	if (n == 0)
+		PG_RETURN_NULL();
 
-	if (!PG_ARGISNULL(1))
-		do_duration_discard(state, PG_GETARG_DURATION(1));
+	duration_array_extremes(values, n, &min, &max);
+	if (!duration_array_infinite(min, max, &result))
+		result = duration_sum_result(duration_array_total(values, n));
 
-	PG_RETURN_POINTER(state);
+	PG_RETURN_DURATION(result);
 }
 
-/* avg(duration) aggregate final function */
+/*
+ * array_avg(duration[]) - like avg(duration) over the non-null elements.
+ */
 Datum
-duration_avg(PG_FUNCTION_ARGS)
+duration_array_avg(PG_FUNCTION_ARGS)
 {
-	DurationAggState *state;
-
-	state = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
+	ArrayType  *array = PG_GETARG_ARRAYTYPE_P(0);
+	Duration   *values;
+	Duration	min;
+	Duration	max;
+	Duration	result;
+	int			n;
 
-	/* If there were no non-null inputs, return NULL */
-	if (state == NULL || DA_TOTAL_COUNT(state) == 0)
+	values = duration_array_values(array, &n);
+	if (n == 0)
 		PG_RETURN_NULL();
 
-	/*
-	 * Aggregating infinities that all have the same sign produces infinity
-	 * with that sign.  Aggregating infinities with different signs results in
-	 * an error.
-	 */
-	if (state->pInfcount > 0 || state->nInfcount > 0)
-	{
-		Duration	result;
-
-		if (state->pInfcount > 0 && state->nInfcount > 0)
-			ereport(ERROR,
-					(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
-					 errmsg("duration out of range")));
-
-		if (state->pInfcount > 0)
-			DURATION_NOEND(result);
-		else
-			DURATION_NOBEGIN(result);
-
-		PG_RETURN_DURATION(result);
-	}
+	duration_array_extremes(values, n, &min, &max);
+	if (!duration_array_infinite(min, max, &result))
+		result = duration_sum_mean(duration_array_total(values, n), n);
 
-	return DirectFunctionCall2(duration_div,
-							   DurationGetDatum(state->sumX),
-							   Float8GetDatum((double) state->N));
+	PG_RETURN_DURATION(result);
 }
 
-/* sum(duration) aggregate final function */
 Datum
-duration_sum(PG_FUNCTION_ARGS)
+duration_array_min(PG_FUNCTION_ARGS)
 {
-	DurationAggState *state;
-	Duration	result;
-
-	state = PG_ARGISNULL(0) ? NULL : (DurationAggState *) PG_GETARG_POINTER(0);
-
-	/* If there were no non-null inputs, return NULL */
-	if (state == NULL || DA_TOTAL_COUNT(state) == 0)
+	ArrayType  *array = PG_GETARG_ARRAYTYPE_P(0);
+	Duration   *values;
+	Duration	min;
+	Duration	max;
+	int			n;
+
+	values = duration_array_values(array, &n);
+	if (n == 0)
 		PG_RETURN_NULL();
 
-	/*
-	 * Aggregating infinities that all have the same sign produces infinity
-	 * with that sign.  Aggregating infinities with different signs results in
-	 * an error.
-	 */
-	if (state->pInfcount > 0 && state->nInfcount > 0)
-		ereport(ERROR,
-				(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
-				 errmsg("duration out of range")));
-
-	if (state->pInfcount > 0)
-		DURATION_NOEND(result);
-	else if (state->nInfcount > 0)
-		DURATION_NOBEGIN(result);
-	else
-		result = state->sumX;
+	duration_array_extremes(values, n, &min, &max);
 
-	PG_RETURN_DURATION(result);
+	PG_RETURN_DURATION(min);
 }
 
 Datum
-duration_smaller(PG_FUNCTION_ARGS)
+duration_array_max(PG_FUNCTION_ARGS)
 {
-	Duration	a = PG_GETARG_DURATION(0);
-	Duration	b = PG_GETARG_DURATION(1);
-	int			cmp;
-	Duration	result;
+	ArrayType  *array = PG_GETARG_ARRAYTYPE_P(0);
+	Duration   *values;
+	Duration	min;
+	Duration	max;
+	int			n;
+
+	values = duration_array_values(array, &n);
+	if (n == 0)
+		PG_RETURN_NULL();
 
-	cmp = DatumGetInt32(DirectFunctionCall2(duration_cmp, a, b));
-	result = cmp < 0 ? a : b;
+	duration_array_extremes(values, n, &min, &max);
 
-	PG_RETURN_DURATION(result);
+	PG_RETURN_DURATION(max);
 }
 
+/*
+ * array_sort(duration[]) - sort a one-dimensional array in ascending order,
+ * nulls last, keeping its lower bound.  The copy's data area is radix sorted
+ * in place and, if there are nulls, its null bitmap is rewritten to match.
+ */
 Datum
-duration_larger(PG_FUNCTION_ARGS)
+duration_array_sort(PG_FUNCTION_ARGS)
 {
-	Duration	a = PG_GETARG_DURATION(0);
-	Duration	b = PG_GETARG_DURATION(1);
-	int			cmp;
-	Duration	result;
+	ArrayType  *array = PG_GETARG_ARRAYTYPE_P_COPY(0);
+	bits8	   *bitmap = ARR_NULLBITMAP(array);
+	Duration   *values;
+	int			nitems;
+	int			n;
 
-	cmp = DatumGetInt32(DirectFunctionCall2(duration_cmp, a, b));
-	result = cmp > 0 ? a : b;
+	if (ARR_NDIM(array) > 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("sorting multidimensional duration arrays is not supported")));
 
-	PG_RETURN_DURATION(result);
+	nitems = ArrayGetNItems(ARR_NDIM(array), ARR_DIMS(array));
+	values = duration_array_values(array, &n);
+	duration_radix_sort(values, n);
+
+	if (bitmap != NULL)
+	{
+		memcpy(ARR_DATA_PTR(array), values, n * sizeof(Duration));
+		for (int i = 0; i < nitems; i++)
+		{
+			if (i < n)
+				bitmap[i / 8] |= (1 << (i % 8));
+			else
+				bitmap[i / 8] &= ~(1 << (i % 8));
+		}
+	}
+
+	PG_RETURN_ARRAYTYPE_P(array);
 }
@@ -364,3 +364,823 @@ SELECT * FROM regress.t;
 SELECT d1 FROM regress.t WHERE d1 > '1 hour';
 SELECT d2 FROM regress.t WHERE d2 = '42 seconds 3 microseconds';
 DROP SCHEMA regress CASCADE;
+
+-- Sorting
+
+SELECT d FROM inf_table ORDER BY d;
+SELECT d FROM inf_table ORDER BY d DESC;
+
+-- BRIN indexes
+
+CREATE TEMP TABLE brin_minmax (d duration);
+CREATE TEMP TABLE brin_minmax_multi (d duration);
+CREATE TEMP TABLE brin_bloom (d duration);
+INSERT INTO brin_minmax SELECT make_duration(0, 0, i) FROM generate_series(1, 1000) AS i;
+INSERT INTO brin_minmax_multi
+SELECT make_duration(0, 0, CASE WHEN i % 100 = 0 THEN 100000 + i ELSE i END) FROM generate_series(1, 1000) AS i;
+INSERT INTO brin_bloom SELECT make_duration(0, 0, i * 7919 % 1000) FROM generate_series(1, 1000) AS i;
+CREATE INDEX brin_minmax_idx ON brin_minmax USING BRIN (d) WITH (pages_per_range = 1);
+CREATE INDEX brin_minmax_multi_idx ON brin_minmax_multi USING BRIN (d duration_minmax_multi_ops) WITH (pages_per_range = 1);
+CREATE INDEX brin_bloom_idx ON brin_bloom USING BRIN (d duration_bloom_ops) WITH (pages_per_range = 1);
+CREATE TEMP VIEW brin_counts AS
+SELECT (SELECT count(*) FROM brin_minmax WHERE d > '990 s') AS minmax_gt,
+       (SELECT count(*) FROM brin_minmax WHERE d = '500 s') AS minmax_eq,
+       (SELECT count(*) FROM brin_minmax_multi WHERE d > '100500 s') AS multi_gt,
+       (SELECT count(*) FROM brin_minmax_multi WHERE d = '501 s') AS multi_eq,
+       (SELECT count(*) FROM brin_bloom WHERE d = '500 s') AS bloom_eq;
+SET enable_seqscan = off;
+EXPLAIN (COSTS OFF) SELECT count(*) FROM brin_minmax WHERE d > '990 s';
+EXPLAIN (COSTS OFF) SELECT count(*) FROM brin_minmax_multi WHERE d > '100500 s';
+EXPLAIN (COSTS OFF) SELECT count(*) FROM brin_bloom WHERE d = '500 s';
+CREATE TEMP TABLE brin_indexed AS SELECT * FROM brin_counts;
+RESET enable_seqscan;
+SET enable_bitmapscan = off;
+SELECT i.*, row(i.*) = row(s.*) AS matches_seqscan FROM brin_indexed i, brin_counts s;
+RESET enable_bitmapscan;
+
+-- GiST indexes
+
+SELECT duration '1 s' <-> duration '5 s';
+SELECT duration '5 s' <-> duration '1 s';
+SELECT duration 'infinity' <-> duration '5 s';
+CREATE TEMP TABLE gist_table (d duration);
+INSERT INTO gist_table SELECT make_duration(0, 0, i) FROM generate_series(1, 1000) AS i;
+CREATE INDEX gist_idx ON gist_table USING GIST (d);
+SET enable_seqscan = off;
+EXPLAIN (COSTS OFF) SELECT count(*) FROM gist_table WHERE d < '10 s';
+SELECT count(*) FROM gist_table WHERE d < '10 s';
+SELECT count(*) FROM gist_table WHERE d = '500 s';
+EXPLAIN (COSTS OFF) SELECT d FROM gist_table ORDER BY d <-> '250.4 s' LIMIT 3;
+SELECT d FROM gist_table ORDER BY d <-> '250.4 s' LIMIT 3;
+RESET enable_seqscan;
+CREATE TEMP TABLE gist_excl (
+	d duration,
+	r int4range,
+	EXCLUDE USING GIST (d WITH =, r WITH &&)
+);
+INSERT INTO gist_excl VALUES ('1 s', '[1,5)'), ('2 s', '[1,5)'), ('1 s', '[5,10)');
+INSERT INTO gist_excl VALUES ('1 s', '[3,5)');
+
+-- Range types
+
+SELECT duration_subdiff('2 s', '500 ms');
+SELECT durationrange('100 ms', '250 ms');
+SELECT durationrange('100 ms', '250 ms') @> duration '200 ms';
+SELECT durationrange('100 ms', '250 ms') @> duration '250 ms';
+SELECT durationmultirange(durationrange('1 s', '2 s'), durationrange('3 s', '4 s'));
+SELECT durationmultirange(durationrange('1 s', '2 s'), durationrange('3 s', '4 s')) && durationrange('2.5 s', '2.6 s');
+CREATE TEMP TABLE range_table (r durationrange);
+INSERT INTO range_table SELECT durationrange(make_duration(0, 0, i), make_duration(0, 0, i + 10)) FROM generate_series(1, 1000) AS i;
+CREATE INDEX range_gist_idx ON range_table USING GIST (r);
+CREATE INDEX range_spgist_idx ON range_table USING SPGIST (r);
+SET enable_seqscan = off;
+SELECT count(*) FROM range_table WHERE r @> duration '500 s';
+SELECT count(*) FROM range_table WHERE r && durationrange('100 s', '101 s');
+RESET enable_seqscan;
+
+-- Window RANGE frames
+
+CREATE TEMP TABLE window_table (d duration);
+INSERT INTO window_table VALUES ('0 s'), ('30 s'), ('1 min'), ('90 s'), ('200 s');
+SELECT
+	d,
+	count(*) OVER (ORDER BY d RANGE BETWEEN '1 min' PRECEDING AND CURRENT ROW) AS preceding,
+	count(*) OVER (ORDER BY d RANGE BETWEEN CURRENT ROW AND '1 min' FOLLOWING) AS following,
+	count(*) OVER (ORDER BY d DESC RANGE BETWEEN '1 min' PRECEDING AND CURRENT ROW) AS preceding_desc
+FROM
+	window_table
+ORDER BY
+	d;
+SELECT
+	d,
+	count(*) OVER (ORDER BY d RANGE BETWEEN 'infinity' PRECEDING AND '1 us' PRECEDING) AS inf_preceding,
+	count(*) OVER (ORDER BY d RANGE BETWEEN '9223372036854775806 us' PRECEDING AND '9223372036854775806 us' FOLLOWING) AS huge
+FROM
+	inf_table
+ORDER BY
+	d;
+SELECT count(*) OVER (ORDER BY d RANGE BETWEEN '-1 min' PRECEDING AND CURRENT ROW) FROM window_table;
+
+-- Date/time arithmetic
+
+SELECT timestamp '2024-01-01 00:00:00' + duration '36 hours 30 minutes';
+SELECT timestamp '2024-01-01 00:00:00' - duration '1 us';
+SELECT timestamptz '2024-01-01 00:00:00+00' + duration '36 hours 30 minutes' = timestamptz '2024-01-02 12:30:00+00';
+SELECT timestamptz '2024-01-01 00:00:00+00' - duration '36 hours 30 minutes' = timestamptz '2023-12-30 11:30:00+00';
+SELECT date '2024-01-01' + duration '25 hours';
+SELECT date '2024-01-01' - duration '25 hours';
+SELECT time '23:00' + duration '2 hours';
+SELECT time '01:00' - duration '2 hours';
+SELECT time '01:00' + duration '1000 hours 5 min';
+SELECT time '01:00' + duration '-1000 hours';
+SELECT duration_diff(timestamp '2024-01-03 12:00:00', timestamp '2024-01-01 00:00:00');
+SELECT duration_diff(timestamptz '2024-01-01 00:00:00+00', timestamptz '2024-01-03 12:00:00+00');
+-- Untyped offsets still resolve to the interval operators
+SELECT timestamp '2024-01-01 00:00:00' + '1 day';
+SELECT time '01:00' + '1 hour';
+-- Infinity
+SELECT timestamp 'infinity' + duration '1 hour';
+SELECT timestamp '2024-01-01 00:00:00' + duration 'infinity';
+SELECT timestamp '2024-01-01 00:00:00' - duration 'infinity';
+SELECT timestamp 'infinity' - duration 'infinity';
+SELECT timestamp '-infinity' + duration '-infinity';
+SELECT time '01:00' + duration 'infinity';
+SELECT time '01:00' - duration '-infinity';
+SELECT duration_diff(timestamp 'infinity', timestamp '2024-01-01 00:00:00');
+SELECT duration_diff(timestamp '2024-01-01 00:00:00', timestamp 'infinity');
+SELECT duration_diff(timestamp 'infinity', timestamp 'infinity');
+-- Overflow
+SELECT timestamp '294276-12-31 23:59:59' + duration '1 hour';
+SELECT duration_diff(timestamp '294276-12-31 23:59:59', timestamp '4713-01-01 00:00:00 BC');
+
+-- Aggregate overflow
+
+SELECT sum(d), avg(d) FROM (VALUES (duration '9223372036854775806 us'), ('9223372036854775806 us'), ('-9223372036854775806 us')) AS v(d);
+SELECT avg(d) FROM (VALUES (duration '9223372036854775806 us'), ('9223372036854775806 us')) AS v(d);
+SELECT sum(d) FROM (VALUES (duration '9223372036854775806 us'), ('9223372036854775806 us')) AS v(d);
+SELECT avg(d) FROM (VALUES (duration '1 us'), ('2 us')) AS v(d);
+SELECT avg(d) FROM (VALUES (duration '-1 us'), ('-2 us')) AS v(d);
+SELECT g, avg(d), avg(d::interval) = avg(d)::interval AS matches_interval
+FROM (VALUES (1, duration '1 us'), (1, '4 us'), (2, '-1 us'), (2, '-4 us'), (3, '1 us'), (3, '2 us'),
+             (4, '-3 us'), (4, '-4 us'), (5, '5 us'), (5, '6 us'), (5, '0'), (5, '3 us')) AS v(g, d)
+GROUP BY g ORDER BY g;
+SELECT
+	d,
+	avg(d) OVER (ORDER BY d ROWS BETWEEN 1 PRECEDING AND CURRENT ROW)
+FROM
+	(VALUES (duration '-9223372036854775806 us'), ('9223372036854775806 us'), ('9223372036854775806 us')) AS v(d);
+
+-- Parallel aggregates
+
+CREATE TABLE agg_parallel (d duration);
+INSERT INTO agg_parallel SELECT make_duration(0, 0, i) FROM generate_series(1, 10000) AS i;
+INSERT INTO agg_parallel SELECT duration '4611686018427387903 us' FROM generate_series(1, 100);
+INSERT INTO agg_parallel SELECT duration '-4611686018427387903 us' FROM generate_series(1, 100);
+ANALYZE agg_parallel;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT sum(d), avg(d) FROM agg_parallel;
+SELECT sum(d), avg(d) FROM agg_parallel;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+DROP TABLE agg_parallel;
+
+-- Percentiles
+SELECT percentile_disc(0.5) WITHIN GROUP (ORDER BY d),
+       percentile_cont(0.5) WITHIN GROUP (ORDER BY d),
+       median(d)
+FROM (VALUES ('1 hour'::duration), ('2 hours'), ('4 hours'), ('8 hours')) v(d);
+SELECT percentile_disc(0.5) WITHIN GROUP (ORDER BY d),
+       percentile_cont(0.25) WITHIN GROUP (ORDER BY d)
+FROM (VALUES ('1 hour'::duration), (NULL), ('3 hours')) v(d);
+SELECT percentile_disc(ARRAY[0, 0.1, 0.5, NULL, 1]) WITHIN GROUP (ORDER BY d),
+       percentile_cont(ARRAY[[0.25, 0.75], [0.5, 1]]) WITHIN GROUP (ORDER BY d)
+FROM (VALUES ('10 seconds'::duration), ('20 seconds'), ('30 seconds'), ('-40 seconds')) v(d);
+SELECT percentile_cont(0.5) WITHIN GROUP (ORDER BY d), median(d)
+FROM (VALUES ('-infinity'::duration), ('1 second'), ('infinity')) v(d);
+SELECT percentile_cont(0.75) WITHIN GROUP (ORDER BY d)
+FROM (VALUES ('-infinity'::duration), ('1 second'), ('infinity')) v(d);
+SELECT percentile_cont(0.5) WITHIN GROUP (ORDER BY d)
+FROM (VALUES ('-infinity'::duration), ('infinity')) v(d);
+SELECT percentile_cont(0.25) WITHIN GROUP (ORDER BY d)
+FROM (VALUES ('-infinity'::duration), ('1 second'), ('infinity')) v(d);
+SELECT percentile_cont(0.75) WITHIN GROUP (ORDER BY d)
+FROM (VALUES ('1 second'::duration), ('infinity'), ('infinity')) v(d);
+SELECT percentile_cont(ARRAY[0, 0.5, 1]) WITHIN GROUP (ORDER BY d)
+FROM (VALUES ('-infinity'::duration), ('1 second'), ('infinity')) v(d);
+SELECT percentile_cont(0.5) WITHIN GROUP (ORDER BY d), percentile_cont(0.25) WITHIN GROUP (ORDER BY d)
+FROM (VALUES ('9223372036854775000 us'::duration), ('9223372036854775006 us')) v(d);
+SELECT percentile_cont(0.5) WITHIN GROUP (ORDER BY d), percentile_cont(0.25) WITHIN GROUP (ORDER BY d)
+FROM (VALUES ('-9223372036854775006 us'::duration), ('-9223372036854775000 us')) v(d);
+SELECT percentile_cont(0.5) WITHIN GROUP (ORDER BY d), median(d)
+FROM (SELECT '1 hour'::duration WHERE false) v(d);
+SELECT percentile_cont(1.5) WITHIN GROUP (ORDER BY d)
+FROM (VALUES ('1 hour'::duration)) v(d);
+-- large inputs exercise the radix sort, and spill to a tuplesort past work_mem
+SELECT percentile_disc(ARRAY[0, 0.5, 1]) WITHIN GROUP (ORDER BY d),
+       percentile_cont(0.3) WITHIN GROUP (ORDER BY d), median(d)
+FROM (SELECT '1 second'::duration * (((i * 7919) % 20001) - 10000)
+      FROM generate_series(1, 20001) i) v(d);
+SET work_mem = '64kB';
+SELECT percentile_disc(ARRAY[0, 0.5, 1]) WITHIN GROUP (ORDER BY d),
+       percentile_cont(0.3) WITHIN GROUP (ORDER BY d), median(d)
+FROM (SELECT '1 second'::duration * (((i * 7919) % 20001) - 10000)
+      FROM generate_series(1, 20001) i) v(d);
+RESET work_mem;
+
+-- Quantile sketches
+SELECT duration_sketch_agg(d)
+FROM (VALUES ('1 second'::duration), ('1 second'), ('0'), ('-5 minutes'), (NULL)) v(d);
+SELECT duration_sketch_agg(d, 0.05)
+FROM (VALUES ('1 second'::duration), ('2 seconds'), ('-infinity'), ('infinity')) v(d);
+SELECT duration_sketch_agg(d) FROM (SELECT '1 hour'::duration WHERE false) v(d);
+SELECT duration_sketch_agg(d, 0.9) FROM (VALUES ('1 hour'::duration)) v(d);
+SELECT 'alpha=0.01 zero=1 ninf=0 pinf=2 min=0 max=1000000 neg={} pos={0:1,691:2}'::duration_sketch;
+SELECT 'alpha=0.01 zero=0 ninf=0 pinf=0 min=0 max=0 neg={} pos={}'::duration_sketch;
+SELECT 'alpha=0.01 zero=0 ninf=0 pinf=0 min=5 max=1 neg={} pos={1:1}'::duration_sketch;
+SELECT 'alpha=0.01 zero=0 ninf=0 pinf=0 min=1 max=5 neg={} pos={2:1,1:1}'::duration_sketch;
+SELECT 'alpha=0.01 zero=0 ninf=0 pinf=0 min=1 max=5 neg={} pos={99999:1}'::duration_sketch;
+SELECT 'alpha=x zero=0'::duration_sketch;
+SELECT pg_input_is_valid('alpha=0.01 zero=0 ninf=0 pinf=0 min=0 max=0 neg={}', 'duration_sketch');
+SELECT q, quantile(s, q)
+FROM (SELECT duration_sketch_agg(d) AS s
+      FROM (VALUES ('-infinity'::duration), ('-1 hour'), ('0'), ('1 second'),
+                   ('1 minute'), ('1 hour'), ('infinity')) v(d)) sk,
+     unnest(ARRAY[0, 0.1, 0.2, 0.4, 0.5, 0.6, 0.7, 1]) q;
+SELECT quantile('alpha=0.01 zero=0 ninf=0 pinf=0 min=0 max=0 neg={} pos={}', 0.5);
+SELECT quantile(duration_sketch_agg('1 second'), 2);
+-- every quantile is within the relative accuracy of the exact percentile
+CREATE TABLE sketch_input AS
+SELECT i % 10 AS g, '1 microsecond'::duration * ((i * 7919) % 100000 + 1) ^ 1.5 AS d
+FROM generate_series(1, 50000) i;
+CREATE TEMP TABLE sketch_serial AS SELECT duration_sketch_agg(d) AS s FROM sketch_input;
+WITH s AS (SELECT duration_sketch_agg(d) AS s FROM sketch_input),
+     q AS (SELECT q FROM unnest(ARRAY[0, 0.01, 0.25, 0.5, 0.9, 0.99, 0.999, 1]) q)
+SELECT q, abs(extract(epoch from quantile(s, q)::interval) -
+              extract(epoch from (SELECT percentile_disc(q) WITHIN GROUP (ORDER BY d)
+                                  FROM sketch_input)::interval)) /
+          extract(epoch from (SELECT percentile_disc(q) WITHIN GROUP (ORDER BY d)
+                              FROM sketch_input)::interval) <= 0.01 AS accurate
+FROM s, q;
+-- merging per-group sketches gives the same sketch as building it at once
+CREATE TEMP TABLE sketch_rollup AS
+SELECT g, duration_sketch_agg(d) AS s FROM sketch_input GROUP BY g;
+SELECT (SELECT sketch_merge(s)::text FROM sketch_rollup) =
+       (SELECT duration_sketch_agg(d)::text FROM sketch_input) AS same;
+SELECT sketch_merge(s) FROM (VALUES (NULL::duration_sketch)) v(s);
+SELECT sketch_merge(s) FROM (SELECT duration_sketch_agg('1 second'::duration, a) AS s
+                             FROM unnest(ARRAY[0.01, 0.02]) a GROUP BY a) v;
+-- parallel aggregation gives the same sketch as a serial one
+ANALYZE sketch_input;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT duration_sketch_agg(d) FROM sketch_input;
+SELECT duration_sketch_agg(d)::text = (SELECT s::text FROM sketch_serial) AS same
+FROM sketch_input;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+DROP TABLE sketch_input;
+
+-- Histograms
+SELECT h.lower, h.upper, h.count
+FROM (SELECT duration_histogram(d) AS h
+      FROM (VALUES ('0'::duration), ('1 microsecond'), ('1 microsecond'), ('-3 microseconds'),
+                   ('1 second'), ('1.001 seconds'), ('-1 hour'), (NULL)) v(d)) s,
+     unnest((h).lower, (h).upper, (h).count) AS h(lower, upper, count);
+SELECT (duration_histogram(d, 1)).*
+FROM (VALUES ('-infinity'::duration), ('31 microseconds'), ('32 microseconds'),
+             ('33 microseconds'), ('35 microseconds'), ('infinity')) v(d);
+SELECT h.lower, h.upper, h.count
+FROM (SELECT duration_histogram(d, 3) AS h
+      FROM (VALUES ('9223372036854775806 us'::duration), ('-9223372036854775807 us')) v(d)) s,
+     unnest((h).lower, (h).upper, (h).count) AS h(lower, upper, count);
+SELECT duration_histogram(d) FROM (SELECT '1 hour'::duration WHERE false) v(d);
+SELECT duration_histogram(d, 5) FROM (VALUES ('1 hour'::duration)) v(d);
+-- every value falls in its bucket, and buckets are narrower than 1%
+CREATE TABLE histogram_input AS
+SELECT '1 microsecond'::duration * ((i * 7919) % 100000 + 1) ^ 1.5 AS d
+FROM generate_series(1, 50000) i;
+WITH h AS (SELECT b.* FROM (SELECT duration_histogram(d) AS h FROM histogram_input) s,
+                          unnest((h).lower, (h).upper, (h).count) AS b(lower, upper, count))
+SELECT sum(count) = (SELECT count(*) FROM histogram_input) AS total,
+       bool_and(count = (SELECT count(*) FROM histogram_input
+                         WHERE d >= lower AND d < upper)) AS counts,
+       bool_and(upper - lower <= greatest(lower / 100, '1 microsecond')) AS widths
+FROM h;
+CREATE TEMP TABLE histogram_serial AS SELECT duration_histogram(d) AS h FROM histogram_input;
+ANALYZE histogram_input;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT duration_histogram(d) FROM histogram_input;
+SELECT duration_histogram(d)::text = (SELECT h::text FROM histogram_serial) AS same
+FROM histogram_input;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+DROP TABLE histogram_input;
+
+-- Variance and standard deviation
+SELECT var_pop(d), var_samp(d), variance(d), stddev_pop(d), stddev_samp(d), stddev(d)
+FROM (VALUES ('1 second'::duration), ('2 seconds'), ('3 seconds'), ('4 seconds'), (NULL)) v(d);
+SELECT var_pop(d), var_samp(d), stddev_pop(d), stddev_samp(d)
+FROM (VALUES ('1 hour'::duration)) v(d);
+SELECT var_pop(d), var_samp(d), stddev_pop(d), stddev_samp(d)
+FROM (SELECT '1 hour'::duration WHERE false) v(d);
+SELECT var_pop(d), var_samp(d)
+FROM (VALUES ('1 hour'::duration), ('infinity'), ('-infinity')) v(d);
+SELECT var_pop(d), var_samp(d)
+FROM (VALUES ('1 hour'::duration), ('infinity')) v(d);
+SELECT stddev_pop(d)
+FROM (VALUES ('1 hour'::duration), ('infinity')) v(d);
+SELECT stddev_samp(d)
+FROM (VALUES ('1 hour'::duration), ('-infinity'), ('infinity')) v(d);
+-- the sums of squares are exact, even for the largest durations
+SELECT var_samp(d), stddev_samp(d)
+FROM (VALUES ('9223372036854775806 us'::duration), ('-9223372036854775807 us'),
+             ('9223372036854775806 us'), ('-9223372036854775807 us'),
+             ('9223372036854775806 us'), ('1 us')) v(d);
+SELECT stddev_samp(d)
+FROM (VALUES ('9223372036854775806 us'::duration), ('-9223372036854775807 us')) v(d);
+SELECT stddev_pop(d)
+FROM (VALUES ('9223372036854775806 us'::duration), ('9223372036854775806 us'),
+             ('9223372036854775806 us'), ('9223372036854775806 us'),
+             ('9223372036854775806 us'), ('9223372036854775805 us')) v(d);
+SELECT i, var_pop(d) OVER w
+FROM (VALUES (1, '1 second'::duration), (2, '3 seconds'), (3, 'infinity'), (4, '10 seconds'),
+             (5, '9223372036854775806 us'), (6, '-1 second'), (7, '5 minutes'),
+             (8, NULL), (9, '10 minutes')) v(i, d)
+WINDOW w AS (ORDER BY i ROWS BETWEEN 1 PRECEDING AND CURRENT ROW);
+SELECT i, stddev_samp(d) OVER w, var_pop(d) OVER w
+FROM (VALUES (1, '1 second'::duration), (2, '3 seconds'), (4, '10 seconds'),
+             (5, '9223372036854775806 us'), (6, '-1 second'), (7, '5 minutes'),
+             (8, NULL), (9, '10 minutes')) v(i, d)
+WINDOW w AS (ORDER BY i ROWS BETWEEN 1 PRECEDING AND CURRENT ROW);
+CREATE TABLE var_parallel AS
+SELECT '1 microsecond'::duration * ((i * 7919) % 100000 + 1) ^ 2.5 AS d
+FROM generate_series(1, 20000) i;
+CREATE TEMP TABLE var_serial AS
+SELECT var_samp(d) AS v, stddev_pop(d) AS s FROM var_parallel;
+ANALYZE var_parallel;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT var_samp(d), stddev_pop(d) FROM var_parallel;
+SELECT var_samp(d) = v AS var_same, stddev_pop(d) = s AS stddev_same
+FROM var_parallel, var_serial GROUP BY v, s;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+SELECT abs(extract(epoch from stddev_samp(d)) - stddev_samp(extract(epoch from d)::float8)) < 1e-6
+FROM var_parallel;
+DROP TABLE var_parallel;
+
+-- Series
+SELECT * FROM generate_series('1 hour'::duration, '2 hours', '20 minutes');
+SELECT * FROM generate_series('1 hour'::duration, '-1 hour', '-45 minutes');
+SELECT * FROM generate_series('1 hour'::duration, '2 hours', '-1 minute');
+SELECT * FROM generate_series('9223372036854775800 us'::duration, '9223372036854775806 us', '4 us');
+SELECT * FROM generate_series('-9223372036854775800 us'::duration, '-9223372036854775807 us', '-4 us');
+SELECT * FROM generate_series('1 hour'::duration, '2 hours', '0');
+SELECT * FROM generate_series('1 hour'::duration, '2 hours', 'infinity');
+SELECT * FROM generate_series('-infinity'::duration, '2 hours', '1 hour');
+SELECT * FROM generate_series('1 hour'::duration, 'infinity', '1 hour');
+-- steps are exact, even across a daylight saving time change
+SELECT * FROM generate_series('2024-03-10 08:00:00+00'::timestamptz,
+                              '2024-03-10 12:30:00+00', '90 minutes'::duration);
+SELECT * FROM generate_series('2024-03-10 00:00:00+00'::timestamptz,
+                              '2024-03-09 23:00:00+00', '-30 minutes'::duration);
+SELECT * FROM generate_series('infinity'::timestamptz, 'infinity', '1 hour'::duration);
+-- the planner knows exactly how many rows come back
+EXPLAIN SELECT * FROM generate_series('0'::duration, '24 hours', '1 minute');
+EXPLAIN SELECT * FROM generate_series('24 hours'::duration, '0', '-7 minutes');
+EXPLAIN SELECT * FROM generate_series('24 hours'::duration, '0', '7 minutes');
+EXPLAIN SELECT * FROM generate_series('24 hours'::duration, NULL, '7 minutes');
+EXPLAIN SELECT * FROM generate_series(now(), now() + '24 hours'::duration, '15 minutes'::duration);
+
+-- Binning
+SELECT duration_bin('15 minutes', d), duration_bin('15 minutes', d, '5 minutes')
+FROM (VALUES ('0'::duration), ('14 minutes 59 seconds'), ('15 minutes'), ('-1 us'),
+             ('-15 minutes'), ('-15 minutes 1 us'), ('100 hours 7 minutes')) v(d);
+SELECT duration_bin('1 hour', 'infinity'), duration_bin('1 hour', '-infinity', '10 minutes');
+SELECT duration_bin('0', '1 hour');
+SELECT duration_bin('-1 hour', '1 hour');
+SELECT duration_bin('infinity', '1 hour');
+SELECT duration_bin('1 hour', '1 hour', 'infinity');
+SELECT duration_bin('1 hour', '-9223372036854775800 us');
+SELECT duration_bin('1 hour', '9223372036854775800 us', '-9223372036854775800 us');
+SELECT duration_bin('3 us', '-9223372036854775805 us');
+SELECT duration_bin('4 us', '-9223372036854775805 us');
+SELECT date_bin('15 minutes'::duration, ts, '2001-01-01')
+FROM (VALUES ('2024-03-10 10:22:30'::timestamp), ('2024-03-10 10:15'), ('1999-12-31 23:59:59')) v(ts);
+SELECT date_bin('90 minutes'::duration, '2024-03-10 01:59:00-08'::timestamptz, '2024-03-10 00:00:00-08');
+SELECT date_bin('1 hour'::duration, '-infinity'::timestamptz, '2001-01-01'),
+       date_bin('1 hour'::duration, 'infinity'::timestamp, '2001-01-01');
+SELECT date_bin('0'::duration, '2024-03-10'::timestamptz, '2001-01-01');
+SELECT date_bin('1 hour'::duration, '2024-03-10'::timestamptz, 'infinity');
+SELECT date_bin('100 hours'::duration, '4714-11-24 00:00:00+00 BC'::timestamptz, '2001-01-01');
+
+-- Truncated comparisons
+CREATE TABLE trunc_cmp (d duration);
+INSERT INTO trunc_cmp
+SELECT make_duration(secs => i * 0.25) FROM generate_series(-40, 40) i;
+INSERT INTO trunc_cmp VALUES ('infinity'), ('-infinity'), (NULL);
+CREATE INDEX trunc_cmp_idx ON trunc_cmp (d);
+ANALYZE trunc_cmp;
+SET enable_seqscan = off;
+EXPLAIN (COSTS OFF) SELECT * FROM trunc_cmp WHERE date_trunc('second', d) = '00:00:02';
+EXPLAIN (COSTS OFF) SELECT * FROM trunc_cmp WHERE date_trunc('second', d) = '-00:00:02';
+EXPLAIN (COSTS OFF) SELECT * FROM trunc_cmp WHERE date_trunc('second', d) = '00:00:02.5';
+EXPLAIN (COSTS OFF) SELECT * FROM trunc_cmp WHERE date_trunc('Minute', d) < '00:02:00';
+EXPLAIN (COSTS OFF) SELECT * FROM trunc_cmp WHERE '00:00:01' >= date_trunc('second', d);
+EXPLAIN (COSTS OFF) SELECT * FROM trunc_cmp WHERE date_trunc('second', d) > '-00:00:01'
+  AND date_trunc('second', d) <= '00:00:05';
+-- left alone: inequality, infinite bounds, unsupported units, volatile arguments
+EXPLAIN (COSTS OFF) SELECT * FROM trunc_cmp WHERE date_trunc('second', d) <> '00:00:02';
+EXPLAIN (COSTS OFF) SELECT * FROM trunc_cmp WHERE date_trunc('second', d) = 'infinity';
+EXPLAIN (COSTS OFF) SELECT * FROM trunc_cmp WHERE date_trunc('day', d) = '00:00:00';
+EXPLAIN (COSTS OFF) SELECT * FROM trunc_cmp
+  WHERE date_trunc('second', d + make_duration(secs => random())) = '00:00:02';
+RESET enable_seqscan;
+-- the rewrite returns the same rows as evaluating date_trunc() directly
+SELECT '-00:00:11'::duration AS b,
+       count(*) FILTER (WHERE date_trunc('second', d) = '-00:00:11') =
+       count(*) FILTER (WHERE t = '-00:00:11') AS eq,
+       count(*) FILTER (WHERE date_trunc('second', d) < '-00:00:11') =
+       count(*) FILTER (WHERE t < '-00:00:11') AS lt,
+       count(*) FILTER (WHERE date_trunc('second', d) <= '-00:00:11') =
+       count(*) FILTER (WHERE t <= '-00:00:11') AS le,
+       count(*) FILTER (WHERE date_trunc('second', d) > '-00:00:11') =
+       count(*) FILTER (WHERE t > '-00:00:11') AS gt,
+       count(*) FILTER (WHERE date_trunc('second', d) >= '-00:00:11') =
+       count(*) FILTER (WHERE t >= '-00:00:11') AS ge
+FROM (SELECT d, date_trunc('second', d) AS t FROM trunc_cmp OFFSET 0) s;
+SELECT '-00:00:02'::duration AS b,
+       count(*) FILTER (WHERE date_trunc('second', d) = '-00:00:02') =
+       count(*) FILTER (WHERE t = '-00:00:02') AS eq,
+       count(*) FILTER (WHERE date_trunc('second', d) < '-00:00:02') =
+       count(*) FILTER (WHERE t < '-00:00:02') AS lt,
+       count(*) FILTER (WHERE date_trunc('second', d) <= '-00:00:02') =
+       count(*) FILTER (WHERE t <= '-00:00:02') AS le,
+       count(*) FILTER (WHERE date_trunc('second', d) > '-00:00:02') =
+       count(*) FILTER (WHERE t > '-00:00:02') AS gt,
+       count(*) FILTER (WHERE date_trunc('second', d) >= '-00:00:02') =
+       count(*) FILTER (WHERE t >= '-00:00:02') AS ge
+FROM (SELECT d, date_trunc('second', d) AS t FROM trunc_cmp OFFSET 0) s;
+SELECT '-00:00:01.5'::duration AS b,
+       count(*) FILTER (WHERE date_trunc('second', d) = '-00:00:01.5') =
+       count(*) FILTER (WHERE t = '-00:00:01.5') AS eq,
+       count(*) FILTER (WHERE date_trunc('second', d) < '-00:00:01.5') =
+       count(*) FILTER (WHERE t < '-00:00:01.5') AS lt,
+       count(*) FILTER (WHERE date_trunc('second', d) <= '-00:00:01.5') =
+       count(*) FILTER (WHERE t <= '-00:00:01.5') AS le,
+       count(*) FILTER (WHERE date_trunc('second', d) > '-00:00:01.5') =
+       count(*) FILTER (WHERE t > '-00:00:01.5') AS gt,
+       count(*) FILTER (WHERE date_trunc('second', d) >= '-00:00:01.5') =
+       count(*) FILTER (WHERE t >= '-00:00:01.5') AS ge
+FROM (SELECT d, date_trunc('second', d) AS t FROM trunc_cmp OFFSET 0) s;
+SELECT '0'::duration AS b,
+       count(*) FILTER (WHERE date_trunc('second', d) = '0') =
+       count(*) FILTER (WHERE t = '0') AS eq,
+       count(*) FILTER (WHERE date_trunc('second', d) < '0') =
+       count(*) FILTER (WHERE t < '0') AS lt,
+       count(*) FILTER (WHERE date_trunc('second', d) <= '0') =
+       count(*) FILTER (WHERE t <= '0') AS le,
+       count(*) FILTER (WHERE date_trunc('second', d) > '0') =
+       count(*) FILTER (WHERE t > '0') AS gt,
+       count(*) FILTER (WHERE date_trunc('second', d) >= '0') =
+       count(*) FILTER (WHERE t >= '0') AS ge
+FROM (SELECT d, date_trunc('second', d) AS t FROM trunc_cmp OFFSET 0) s;
+SELECT '00:00:01'::duration AS b,
+       count(*) FILTER (WHERE date_trunc('second', d) = '00:00:01') =
+       count(*) FILTER (WHERE t = '00:00:01') AS eq,
+       count(*) FILTER (WHERE date_trunc('second', d) < '00:00:01') =
+       count(*) FILTER (WHERE t < '00:00:01') AS lt,
+       count(*) FILTER (WHERE date_trunc('second', d) <= '00:00:01') =
+       count(*) FILTER (WHERE t <= '00:00:01') AS le,
+       count(*) FILTER (WHERE date_trunc('second', d) > '00:00:01') =
+       count(*) FILTER (WHERE t > '00:00:01') AS gt,
+       count(*) FILTER (WHERE date_trunc('second', d) >= '00:00:01') =
+       count(*) FILTER (WHERE t >= '00:00:01') AS ge
+FROM (SELECT d, date_trunc('second', d) AS t FROM trunc_cmp OFFSET 0) s;
+SELECT '00:00:01.5'::duration AS b,
+       count(*) FILTER (WHERE date_trunc('second', d) = '00:00:01.5') =
+       count(*) FILTER (WHERE t = '00:00:01.5') AS eq,
+       count(*) FILTER (WHERE date_trunc('second', d) < '00:00:01.5') =
+       count(*) FILTER (WHERE t < '00:00:01.5') AS lt,
+       count(*) FILTER (WHERE date_trunc('second', d) <= '00:00:01.5') =
+       count(*) FILTER (WHERE t <= '00:00:01.5') AS le,
+       count(*) FILTER (WHERE date_trunc('second', d) > '00:00:01.5') =
+       count(*) FILTER (WHERE t > '00:00:01.5') AS gt,
+       count(*) FILTER (WHERE date_trunc('second', d) >= '00:00:01.5') =
+       count(*) FILTER (WHERE t >= '00:00:01.5') AS ge
+FROM (SELECT d, date_trunc('second', d) AS t FROM trunc_cmp OFFSET 0) s;
+SELECT '00:00:11'::duration AS b,
+       count(*) FILTER (WHERE date_trunc('second', d) = '00:00:11') =
+       count(*) FILTER (WHERE t = '00:00:11') AS eq,
+       count(*) FILTER (WHERE date_trunc('second', d) < '00:00:11') =
+       count(*) FILTER (WHERE t < '00:00:11') AS lt,
+       count(*) FILTER (WHERE date_trunc('second', d) <= '00:00:11') =
+       count(*) FILTER (WHERE t <= '00:00:11') AS le,
+       count(*) FILTER (WHERE date_trunc('second', d) > '00:00:11') =
+       count(*) FILTER (WHERE t > '00:00:11') AS gt,
+       count(*) FILTER (WHERE date_trunc('second', d) >= '00:00:11') =
+       count(*) FILTER (WHERE t >= '00:00:11') AS ge
+FROM (SELECT d, date_trunc('second', d) AS t FROM trunc_cmp OFFSET 0) s;
+SELECT count(*) FROM trunc_cmp WHERE date_trunc('millisecond', d) < '9223372036854775806 us';
+SELECT count(*) FROM trunc_cmp WHERE date_trunc('hour', d) >= '-9223372036854775806 us';
+DROP TABLE trunc_cmp;
+
+-- Fast-path input
+CREATE TABLE fast_in (d duration);
+INSERT INTO fast_in VALUES ('0'), ('1 us'), ('-1 us'), ('00:00:59.999999'), ('-01:30:00'),
+  ('2562047788:00:54.775806'), ('-2562047788:00:54.775806'), ('123456789:59:59.5');
+SET IntervalStyle = postgres;
+SELECT d, d::text::duration = d AS round_trip FROM fast_in;
+SET IntervalStyle = sql_standard;
+SELECT d, d::text::duration = d AS round_trip FROM fast_in;
+SET IntervalStyle = iso_8601;
+SELECT d, d::text::duration = d AS round_trip FROM fast_in;
+RESET IntervalStyle;
+SELECT d, d::text::duration = d AS round_trip FROM fast_in;
+DROP TABLE fast_in;
+-- fractions round the same way as in the general parser
+SELECT '0.5 us'::duration, '1.5 us'::duration, '2.5 us'::duration, '-0.5 us'::duration,
+       '1.0000005 s'::duration, '0.1234567 hours'::duration, 'PT65536.0000005S'::duration;
+SELECT '1 hour 2 mins 3.5 secs ago'::duration, '@ 1 hour ago'::duration, '1h 30m'::duration,
+       'PT1H1H'::duration, ' 01:02:03 '::duration, '+01:02:03'::duration, '5'::duration;
+-- forms left to the general parser
+SELECT '00:00:60'::duration, '1:2:3'::duration, '2 hours 3'::duration, '1h30m'::duration;
+SELECT pg_input_is_valid('1 hour 2 hours', 'duration'), pg_input_is_valid('1.5 s 3 ms', 'duration'),
+       pg_input_is_valid('1.0 s 3 ms', 'duration'), pg_input_is_valid('1hour2min', 'duration'),
+       pg_input_is_valid('5 ago', 'duration'), pg_input_is_valid('PT', 'duration');
+SET IntervalStyle = sql_standard;
+SELECT '-1 hour 2 minutes'::duration, '-1 hour -2 minutes'::duration;
+RESET IntervalStyle;
+
+-- Direct output
+CREATE TABLE direct_out AS
+SELECT (s * (i::int8 * 7919 % 100003) * pow(10, i % 14)::int8 || ' us')::duration AS d
+FROM generate_series(1, 5000) i, (VALUES (1), (-1)) v(s)
+UNION ALL
+SELECT unnest('{0, 1 us, -1 us, 1 s, -1 s, 1.5 s, 1 min, 1 min 1 s, 1 hour, -1 hour, 1 hour 1 min,
+               10 hours 0.000001 s, 59 mins 59.999999 s, 2562047788 hours 54.775806 secs,
+               -2562047788 hours -54.775806 secs}'::duration[]);
+-- the text matches what EncodeInterval() writes for the same value
+SET IntervalStyle = postgres;
+SELECT count(*) FILTER (WHERE d::text <> d::interval::text) AS mismatches FROM direct_out;
+SELECT d FROM direct_out ORDER BY d LIMIT 3;
+SET IntervalStyle = sql_standard;
+SELECT count(*) FILTER (WHERE d::text <> d::interval::text) AS mismatches FROM direct_out;
+SELECT d FROM direct_out ORDER BY d LIMIT 3;
+SET IntervalStyle = iso_8601;
+SELECT count(*) FILTER (WHERE d::text <> d::interval::text) AS mismatches FROM direct_out;
+SELECT d FROM direct_out ORDER BY d LIMIT 3;
+RESET IntervalStyle;
+SELECT count(*) FILTER (WHERE d::text <> d::interval::text) AS mismatches FROM direct_out;
+SELECT d FROM direct_out ORDER BY d LIMIT 3;
+DROP TABLE direct_out;
+
+-- Bigint
+SELECT 1500000::int8::duration, (-1)::int8::duration, '1 hour'::duration::int8, '-1 us'::duration::int8;
+SELECT 9223372036854775807::int8::duration;
+SELECT (-9223372036854775807 - 1)::int8::duration;
+SELECT to_duration_micros(9223372036854775806) = '9223372036854775806 us',
+       to_duration_micros(-9223372036854775807) = '-9223372036854775807 us',
+       9223372036854775807::int8 = 'infinity'::duration, (-9223372036854775807 - 1)::int8 = '-infinity'::duration;
+SELECT 'infinity'::duration::int8;
+SELECT duration_to_micros('-infinity');
+SELECT to_duration_nanos(n)
+FROM (VALUES (0::int8), (499), (500), (1499), (-499), (-500), (-1500), (9223372036854775807),
+             (-9223372036854775807 - 1)) v(n);
+SELECT '1 s'::duration < 1000001::int8, '1 s'::duration <= 1000000::int8, '1 s'::duration = 1000000::int8,
+       '1 s'::duration <> 1000000::int8, '1 s'::duration >= 1000001::int8, '1 s'::duration > 999999::int8;
+SELECT 1000001::int8 < '1 s'::duration, 1000000::int8 <= '1 s'::duration, 1000000::int8 = '1 s'::duration,
+       1000000::int8 <> '1 s'::duration, 1000001::int8 >= '1 s'::duration, 999999::int8 > '1 s'::duration;
+SELECT 'infinity'::duration > 9223372036854775806::int8, '-infinity'::duration < (-9223372036854775807)::int8;
+CREATE TABLE int8_cmp (d duration);
+INSERT INTO int8_cmp SELECT make_duration(secs => i / 10.0) FROM generate_series(1, 1000) i;
+CREATE INDEX int8_cmp_idx ON int8_cmp (d);
+ANALYZE int8_cmp;
+EXPLAIN (COSTS OFF) SELECT * FROM int8_cmp WHERE d > 99500000::int8;
+SELECT * FROM int8_cmp WHERE d > 99500000::int8;
+EXPLAIN (COSTS OFF) SELECT * FROM int8_cmp WHERE 250000 >= d;
+SELECT * FROM int8_cmp WHERE 250000 >= d;
+CREATE TABLE int8_join (n int8);
+INSERT INTO int8_join VALUES (100000), (150000), (200000);
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+EXPLAIN (COSTS OFF) SELECT * FROM int8_cmp JOIN int8_join ON d = n;
+SELECT * FROM int8_cmp JOIN int8_join ON d = n ORDER BY d;
+RESET enable_mergejoin;
+RESET enable_nestloop;
+DROP TABLE int8_cmp, int8_join;
+-- the core int8 operators stay out of duration_ops, so int8 equalities still
+-- combine with those of the other integer types
+CREATE TABLE int8_ec (x int8);
+INSERT INTO int8_ec SELECT i FROM generate_series(1, 1000) i;
+CREATE INDEX int8_ec_idx ON int8_ec (x);
+CREATE TABLE int4_ec (y int4);
+INSERT INTO int4_ec SELECT i FROM generate_series(1, 1000) i;
+CREATE TABLE int2_ec (z int2);
+INSERT INTO int2_ec SELECT i FROM generate_series(1, 1000) i;
+ANALYZE int8_ec, int4_ec, int2_ec;
+EXPLAIN (COSTS OFF) SELECT * FROM int8_ec JOIN int4_ec ON x = y WHERE y = 5;
+EXPLAIN (COSTS OFF) SELECT * FROM int8_ec JOIN int4_ec ON x = y JOIN int2_ec ON y = z;
+DROP TABLE int8_ec, int4_ec, int2_ec;
+
+-- Interval comparisons
+SELECT '1 hour'::duration < interval '61 min', '1 hour'::duration <= interval '60 min', '1 hour'::duration = interval '3600 s',
+       '1 hour'::duration <> interval '3600 s', '1 hour'::duration >= interval '61 min', '1 hour'::duration > interval '59 min';
+SELECT interval '61 min' > '1 hour'::duration, interval '60 min' >= '1 hour'::duration, interval '3600 s' = '1 hour'::duration,
+       interval '3600 s' <> '1 hour'::duration, interval '61 min' <= '1 hour'::duration, interval '59 min' < '1 hour'::duration;
+SELECT '24 hours'::duration = interval '1 day', '720 hours'::duration = interval '1 month',
+       '721 hours'::duration > interval '1 month 1 hour -1 us', '-25 hours'::duration < interval '-1 day';
+SELECT 'infinity'::duration = interval 'infinity', '-infinity'::duration = interval '-infinity',
+       'infinity'::duration > interval '178000000 years', '-infinity'::duration < interval '-178000000 years',
+       '9223372036 s'::duration < interval '178000000 years', 'infinity'::duration < interval 'infinity';
+SELECT d, i, duration_interval_cmp(d, i) AS cmp, d::interval = i AS cast_eq, d::interval < i AS cast_lt,
+       hash_duration(d) = duration_hash_interval(i) AS hash_eq
+FROM (VALUES ('-infinity'::duration, interval '-infinity'), ('infinity', interval 'infinity'), ('24 hours', interval '1 day'),
+             ('720 hours', interval '1 mon'), ('-3 s', interval '-3 s'), ('1 s', interval '1 day')) v(d, i);
+CREATE TABLE interval_cmp (d duration);
+INSERT INTO interval_cmp SELECT make_duration(mins => i) FROM generate_series(1, 2000) i;
+CREATE INDEX interval_cmp_idx ON interval_cmp (d);
+ANALYZE interval_cmp;
+EXPLAIN (COSTS OFF) SELECT * FROM interval_cmp WHERE d < interval '5 min';
+SELECT * FROM interval_cmp WHERE d < interval '5 min';
+EXPLAIN (COSTS OFF) SELECT * FROM interval_cmp WHERE interval '1 day 9 hours' <= d;
+SELECT * FROM interval_cmp WHERE interval '1 day 9 hours' <= d;
+CREATE TABLE interval_join (i interval);
+INSERT INTO interval_join VALUES ('1 hour'), ('1 day'), ('1 day 1 min 1 s');
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+EXPLAIN (COSTS OFF) SELECT * FROM interval_cmp JOIN interval_join ON d = i;
+SELECT * FROM interval_cmp JOIN interval_join ON d = i ORDER BY d;
+RESET enable_mergejoin;
+RESET enable_nestloop;
+DROP TABLE interval_cmp, interval_join;
+-- bigint and interval, neither of which the extension owns, still cannot be compared
+SELECT 3600000000::int8 = interval '1 hour';
+SELECT am.amname, amop.amoplefttype::regtype, amop.amoprighttype::regtype, count(*)
+FROM pg_amop amop JOIN pg_opfamily opf ON opf.oid = amop.amopfamily JOIN pg_am am ON am.oid = opf.opfmethod
+WHERE opf.opfname = 'duration_ops' AND am.amname IN ('btree', 'hash')
+GROUP BY 1, 2, 3
+ORDER BY 1, 2, 3;
+
+-- Integer arithmetic
+SELECT '1.5 s'::duration * 3::int8, 3::int8 * '-1.5 s'::duration, '1 s'::duration * 0::int8, 'infinity'::duration * (-2)::int8;
+SELECT '1 s'::duration * 9223372036854::int8;
+SELECT '1 s'::duration * 9223372036855::int8;
+SELECT 'infinity'::duration * 0::int8;
+SELECT d, n, d / n AS int_div, d / n::float8 AS float_div
+FROM (VALUES ('10 us'::duration, 4::int8), ('14 us', 4), ('-10 us', 4), ('-14 us', 4), ('10 us', -4), ('7 us', 2),
+             ('-7 us', -2), ('1 hour', 7), ('-infinity', -3), ('infinity', 5)) v(d, n);
+SELECT '9223372036854775806 us'::duration / 3::int8, ('9223372036854775806 us'::duration / 3::float8)::int8,
+       '-9223372036854775807 us'::duration / (-9223372036854775807 - 1)::int8;
+SELECT '1 s'::duration / 0::int8;
+SELECT a, b, duration_div_duration(a, b) AS ratio, div(a, b), a % b AS mod
+FROM (VALUES ('7 s'::duration, '2 s'::duration), ('-7 s', '2 s'), ('7 s', '-2 s'), ('1 hour', '90 s'), ('1 us', '3 us'),
+             ('9223372036854775806 us', '1 us'), ('5 s', 'infinity'), ('-5 s', '-infinity')) v(a, b);
+SELECT duration_div_duration('infinity', '1 s'), duration_div_duration('-infinity', '1 s'), duration_div_duration('infinity', 'infinity');
+SELECT div('infinity'::duration, '1 s');
+SELECT 'infinity'::duration % '1 s';
+SELECT duration_div_duration('1 s', '0 s');
+SELECT div('1 s'::duration, '0 s');
+SELECT '1 s'::duration % '0 s';
+SELECT sum(d) / count(*) AS mean, avg(d) FROM (VALUES ('1 s'::duration), ('2 s'), ('4 s')) v(d);
+SELECT '1 hour'::duration / '2', '1 hour'::duration / '2' = '1 hour'::duration / 2::float8 AS float8_div,
+       '1 hour'::interval / '2' AS interval_div;
+
+-- Hashing
+SELECT hash_duration_extended('1 hour', 0) = hashint8extended(3600000000, 0),
+       hash_duration_extended('1 hour', 42) = hashint8extended(3600000000, 42),
+       hash_duration_extended('1 hour', 42) <> hash_duration_extended('1 hour', 0),
+       duration_hash_interval_extended(interval '1 hour', 42) = hash_duration_extended('1 hour', 42),
+       duration_hash_interval_extended(interval 'infinity', 7) = hash_duration_extended('infinity', 7);
+CREATE TABLE hash_part (d duration) PARTITION BY HASH (d);
+CREATE TABLE hash_part_0 PARTITION OF hash_part FOR VALUES WITH (MODULUS 3, REMAINDER 0);
+CREATE TABLE hash_part_1 PARTITION OF hash_part FOR VALUES WITH (MODULUS 3, REMAINDER 1);
+CREATE TABLE hash_part_2 PARTITION OF hash_part FOR VALUES WITH (MODULUS 3, REMAINDER 2);
+INSERT INTO hash_part SELECT make_duration(secs => i) FROM generate_series(1, 300) i;
+SELECT count(*) > 50 AS spread FROM hash_part GROUP BY tableoid ORDER BY 1;
+EXPLAIN (COSTS OFF) SELECT * FROM hash_part WHERE d = '00:02:00';
+SELECT tableoid::regclass, d FROM hash_part WHERE d = '00:02:00';
+DROP TABLE hash_part;
+CREATE TABLE hash_a (d duration);
+CREATE TABLE hash_b (d duration);
+INSERT INTO hash_a SELECT make_duration(secs => i % 100) FROM generate_series(1, 1000) i;
+INSERT INTO hash_b SELECT make_duration(secs => i) FROM generate_series(1, 100, 10) i;
+ANALYZE hash_a, hash_b;
+SET enable_mergejoin = off;
+SET enable_nestloop = off;
+EXPLAIN (COSTS OFF) SELECT count(*) FROM hash_a JOIN hash_b USING (d);
+SELECT count(*) FROM hash_a JOIN hash_b USING (d);
+RESET enable_nestloop;
+RESET enable_mergejoin;
+EXPLAIN (COSTS OFF) SELECT d FROM hash_a INTERSECT SELECT d FROM hash_b ORDER BY d;
+SELECT d FROM hash_a INTERSECT SELECT d FROM hash_b ORDER BY d;
+SELECT count(*) FROM hash_a
+WHERE d = ANY ('{1 s, 2 s, 3 s, 5 s, 8 s, 13 s, 21 s, 34 s, 55 s, 89 s, 144 s}'::duration[]);
+CREATE INDEX hash_b_idx ON hash_b (d);
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+SET enable_seqscan = off;
+EXPLAIN (COSTS OFF) SELECT count(*) FROM hash_a a JOIN LATERAL (SELECT * FROM hash_b b WHERE b.d = a.d OFFSET 0) s ON true;
+SELECT count(*) FROM hash_a a JOIN LATERAL (SELECT * FROM hash_b b WHERE b.d = a.d OFFSET 0) s ON true;
+RESET enable_seqscan;
+RESET enable_mergejoin;
+RESET enable_hashjoin;
+DROP TABLE hash_a, hash_b;
+
+-- Statistics
+SET pg_duration.track_stats = on;
+SELECT pg_duration_stats_reset();
+SELECT parse_fast + parse_decode + parse_iso8601 + parse_errors + overflow_errors + agg_states + interval_casts AS total
+FROM pg_duration_stats;
+SELECT '00:00:01'::duration, '1 hour 2 min'::duration, 'PT1M'::duration, '01:02'::duration, 'P0DT1H'::duration;
+SELECT pg_input_is_valid('1 parsec', 'duration'), pg_input_is_valid('1 day', 'duration');
+SELECT '9223372036854 s'::duration + '1 s'::duration;
+SELECT '1 hour'::duration * 1e300;
+SELECT sum(d), avg(d), justify_hours(max(d)) FROM (VALUES ('20 hours'::duration), ('30 hours')) v(d);
+SELECT parse_fast, parse_decode, parse_iso8601, parse_errors, overflow_errors, agg_states, interval_casts
+FROM pg_duration_stats;
+SET pg_duration.track_stats = off;
+SELECT '01:02'::duration;
+SELECT parse_decode FROM pg_duration_stats;
+SELECT pg_duration_stats_reset();
+SELECT parse_fast, parse_decode, parse_iso8601, parse_errors, overflow_errors, agg_states, interval_casts
+FROM pg_duration_stats;
+RESET pg_duration.track_stats;
+
+-- Compressed series
+SELECT '{}'::duration_series, '{1 s, 2 s,00:00:03 }'::duration_series, ' { 1 hour } '::duration_series;
+SELECT '{1 s'::duration_series;
+SELECT '{1 s,}'::duration_series;
+SELECT '{1 s} x'::duration_series;
+SELECT pg_input_is_valid('{1 s,1 parsec}', 'duration_series'), pg_input_is_valid('1 s', 'duration_series');
+SELECT s, series_count(s), series_sum(s), series_min(s), series_max(s)
+FROM (VALUES ('{}'::duration_series), ('{5 s}'), ('{3 s,-1 s,3 s}'), ('{-infinity,1 s}'), ('{1 s,infinity,infinity}'),
+             ('{-9223372036854775807 us,9223372036854775806 us,0}')) v(s);
+SELECT series_sum('{-infinity,infinity}');
+SELECT series_sum('{9223372036854775806 us,1 us}');
+SELECT array_agg(d) FROM unnest('{3 s,-infinity,1 s,infinity,0}'::duration_series) d;
+SELECT duration_series_agg(d) FROM (VALUES (NULL::duration)) v(d);
+CREATE TABLE series_src AS
+SELECT i, make_duration(secs => 0.05 + (i * 7919 % 1000) / 1e5) AS d FROM generate_series(1, 3600) i;
+CREATE TABLE series_dst AS SELECT duration_series_agg(d ORDER BY i) AS s FROM series_src;
+SELECT series_count(s), series_sum(s) = (SELECT sum(d) FROM series_src) AS sum_ok,
+       series_min(s) = (SELECT min(d) FROM series_src) AS min_ok, series_max(s) = (SELECT max(d) FROM series_src) AS max_ok,
+       round(pg_column_size(s) / 3600.0, 2) AS bytes_per_value
+FROM series_dst;
+SELECT count(*) AS mismatches
+FROM (SELECT d, row_number() OVER () AS i FROM series_dst, unnest(s) d) u JOIN series_src USING (i)
+WHERE u.d <> series_src.d;
+SELECT s::text::duration_series::text = s::text AS text_round_trip FROM series_dst;
+SELECT array_agg(d) FROM unnest('{9223372036854775806 us,-9223372036854775807 us,1 us}'::duration_series) d;
+DROP TABLE series_src, series_dst;
+
+-- Array functions
+SELECT a, array_sum(a), array_avg(a), array_min(a), array_max(a), array_sort(a)
+FROM (VALUES ('{}'::duration[]), ('{NULL}'), ('{5 s}'), ('{3 s,NULL,-1 s,2 s,NULL}'), ('[0:2]={1 us,2 us,2 us}'),
+             ('{1 s,infinity,-2 s}'), ('{-infinity,1 s,-infinity}')) v(a);
+SELECT array_sum('{-infinity,infinity}'), array_sum('{9223372036854775806 us,1 us}');
+SELECT array_avg('{infinity,-infinity}');
+SELECT array_avg('{9223372036854775806 us,9223372036854775806 us}'), array_avg('{1 us,2 us}'), array_avg('{-1 us,-2 us}');
+SELECT array_avg('{1 us,4 us}'), array_avg('{-1 us,-4 us}'), array_avg('{5 us,6 us,0,3 us}');
+SELECT array_sum(a), array_min(a), array_max(a) FROM (VALUES ('{{4 s,1 s},{3 s,NULL}}'::duration[])) v(a);
+SELECT array_sort('{{2 s,1 s},{3 s,4 s}}'::duration[]);
+CREATE TABLE array_src AS
+SELECT i, CASE WHEN i % 97 = 0 THEN NULL ELSE make_duration(secs => (i * 7919 % 10007 - 5000) / 1e3) END AS d
+FROM generate_series(1, 5000) i;
+SELECT array_sum(a) = (SELECT sum(d) FROM array_src) AS sum_ok, array_avg(a) = (SELECT avg(d) FROM array_src) AS avg_ok,
+       array_min(a) = (SELECT min(d) FROM array_src) AS min_ok, array_max(a) = (SELECT max(d) FROM array_src) AS max_ok,
+       array_sort(a) = (SELECT array_agg(d ORDER BY d NULLS LAST) FROM array_src) AS sort_ok
+FROM (SELECT array_agg(d ORDER BY i) AS a FROM array_src) s;
+DROP TABLE array_src;
+-- large values of both signs, whose running sum leaves the int64 range
+SELECT array_sum(a) = '500500 us' AS sum_ok, array_min(a), array_max(a), array_avg(a)
+FROM (SELECT array_agg(to_duration_micros(x) ORDER BY i, x DESC) AS a
+      FROM generate_series(1, 1000) i,
+           LATERAL (VALUES ((i * 7919 % 10007)::int8 * 921658000000000)) m(v),
+           LATERAL (VALUES (v), (i - v)) x(x)) s;
+
+-- Moving min and max
+SELECT i, d,
+	min(d) OVER (ORDER BY i ROWS BETWEEN 2 PRECEDING AND CURRENT ROW) AS min_3,
+	max(d) OVER (ORDER BY i ROWS BETWEEN 2 PRECEDING AND CURRENT ROW) AS max_3,
+	min(d) OVER (ORDER BY i ROWS BETWEEN 1 FOLLOWING AND 2 FOLLOWING) AS min_next,
+	max(d) OVER (ORDER BY i ROWS BETWEEN 1 FOLLOWING AND 2 FOLLOWING) AS max_next
+FROM (VALUES (1, duration '3 s'), (2, '1 s'), (3, NULL), (4, '1 s'), (5, '5 s'), (6, 'infinity'),
+             (7, NULL), (8, NULL), (9, '-infinity'), (10, '2 s')) v(i, d);
+CREATE TABLE minmax_src AS
+SELECT i, CASE WHEN i % 53 = 0 THEN NULL ELSE make_duration(secs => (i * 7919 % 10007) / 1e3) END AS d,
+       make_duration(secs => i) AS rising
+FROM generate_series(1, 5000) i;
+SELECT count(*) FILTER (WHERE min_a IS DISTINCT FROM array_min(a)) AS min_mismatches,
+       count(*) FILTER (WHERE max_a IS DISTINCT FROM array_max(a)) AS max_mismatches,
+       count(*) FILTER (WHERE min_b IS DISTINCT FROM array_min(b)) AS min_mismatches_centered,
+       count(*) FILTER (WHERE max_b IS DISTINCT FROM array_max(b)) AS max_mismatches_centered,
+       count(*) FILTER (WHERE min_r IS DISTINCT FROM array_min(r)) AS min_mismatches_rising,
+       count(*) FILTER (WHERE max_f IS DISTINCT FROM array_max(f)) AS max_mismatches_falling
+FROM (SELECT min(d) OVER a AS min_a, max(d) OVER a AS max_a, array_agg(d) OVER a AS a,
+             min(d) OVER b AS min_b, max(d) OVER b AS max_b, array_agg(d) OVER b AS b,
+             min(rising) OVER r AS min_r, array_agg(rising) OVER r AS r,
+             max(-rising) OVER r AS max_f, array_agg(-rising) OVER r AS f
+      FROM minmax_src
+      WINDOW a AS (ORDER BY i ROWS BETWEEN 99 PRECEDING AND CURRENT ROW),
+             b AS (ORDER BY i ROWS BETWEEN 10 PRECEDING AND 10 FOLLOWING),
+             r AS (ORDER BY i ROWS BETWEEN 999 PRECEDING AND 1 PRECEDING)) w;
+DROP TABLE minmax_src;